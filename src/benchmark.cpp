@@ -17,11 +17,21 @@
 */
 
 #include "benchmark.h"
+#include "experience.h"
+#include "misc.h"
 #include "numa.h"
+#include "position.h"
+#include "ucioption.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
+#include <string_view>
 #include <vector>
 
 namespace {
@@ -368,10 +378,215 @@ const std::vector<std::vector<std::string>> BenchmarkPositions = {
 };
 // clang-format on
 
+// clang-format off
+// A closed Ruy Lopez, replayed ply by ply by the bullet and experience
+// profiles so that consecutive searches share TT, histories and experience.
+constexpr auto ProfileGame =
+  "e2e4 e7e5 g1f3 b8c6 f1b5 a7a6 b5a4 g8f6 e1g1 f8e7 f1e1 b7b5 a4b3 d7d6 c2c3 e8g8 "
+  "h2h3 c6a5 b3c2 c7c5 d2d4 d8c7 b1d2 c5d4 c3d4 a5c6 d2b3 a6a5 c1e3 a5a4 b3d2 c8d7";
+
+const std::vector<std::string> AnalysisPositions = {
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+  "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+  "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+  "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+  "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+  "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+  "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+  "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16"
+};
+
+// Up to 7 pieces, so Syzygy probing runs whenever SyzygyPath is set
+const std::vector<std::string> EndgamePositions = {
+  "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+  "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+  "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+  "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+  "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+  "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+  "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+  "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+  "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+  "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+  "8/8/5pk1/7p/3K3P/8/R4N1r/4b3 b - - 2 64"
+};
+// clang-format on
+
+constexpr auto ProfileExpFile  = "bench_profile.exp";
+constexpr auto ProfileBookFile = "bench_profile.bin";
+
+// Builds the command list of a named profile. Every option a profile sets is
+// restored to its current value at the end, in reverse order.
+class ProfileBuilder {
+   public:
+    explicit ProfileBuilder(const Hypnos::OptionsMap& o) :
+        options(o) {}
+
+    void check(const std::string& name, bool v) {
+        set(name, v ? "true" : "false", int(options[name]) ? "true" : "false");
+    }
+    void spin(const std::string& name, int v) {
+        set(name, std::to_string(v), std::to_string(int(options[name])));
+    }
+    void text(const std::string& name, const std::string& v) {
+        set(name, v, std::string(options[name]));
+    }
+
+    void add(const std::string& cmd) { setup.commands.emplace_back(cmd); }
+
+    void search(const std::string& position, const std::string& go) {
+        add("position " + position);
+        add(go);
+    }
+
+    // Every ply of ProfileGame, from the start position on
+    void game(const std::string& go) {
+        std::istringstream ss(ProfileGame);
+        std::string        moves, move;
+
+        search("startpos", go);
+        while (ss >> move)
+        {
+            moves += " " + move;
+            search("startpos moves" + moves, go);
+        }
+    }
+
+    void restore_options() {
+        setup.commands.insert(setup.commands.end(), restore.rbegin(), restore.rend());
+        restore.clear();
+    }
+
+    Hypnos::Benchmark::BenchSetup setup;
+
+   private:
+    void set(const std::string& name, const std::string& v, const std::string& current) {
+        add("setoption name " + name + " value " + v);
+        restore.emplace_back("setoption name " + name + " value "
+                             + (current.empty() ? "<empty>" : current));
+    }
+
+    const Hypnos::OptionsMap& options;
+    std::vector<std::string>  restore;
+};
+
 }  // namespace
 
 namespace Hypnos::Benchmark {
 
+// Named workloads for "bench profile=<name>". They are fixed command lists
+// searched with one thread and depth or node limits, so node counts are
+// reproducible. 'pgo' runs the default bench followed by all other profiles.
+//
+// analysis   : MultiPV 4 on middlegame positions
+// bullet     : short node-limited searches along ProfileGame
+// endgame    : positions with up to 7 pieces, probes Syzygy if SyzygyPath is set
+// experience : learns ProfileGame into a scratch experience file, then
+//              replays it with experience probes, the Experience Book and a
+//              Polyglot book built from that experience
+BenchSetup setup_bench_profile(const std::string& name,
+                               const std::string& currentFen,
+                               const OptionsMap&  options) {
+
+    static const std::vector<std::string> Profiles = {"analysis", "bullet", "endgame",
+#if defined(HYP_FIXED_ZOBRIST)
+                                                      "experience",
+#endif
+                                                      "pgo"};
+
+    if (std::find(Profiles.begin(), Profiles.end(), name) == Profiles.end())
+    {
+        std::cerr << "Unknown bench profile " << name << ", available:";
+        for (const auto& p : Profiles)
+            std::cerr << ' ' << p;
+        std::cerr << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    const bool     all = name == "pgo";
+    ProfileBuilder b(options);
+
+    if (all)
+    {
+        std::istringstream defaults;
+        b.setup = setup_bench(currentFen, options, defaults);
+    }
+
+    if (all || name == "analysis")
+    {
+        b.spin("Threads", 1);
+        b.spin("Hash", 16);
+        b.spin("MultiPV", 4);
+        b.add("ucinewgame");
+
+        for (const auto& fen : AnalysisPositions)
+            b.search("fen " + fen, "go depth 11");
+
+        b.restore_options();
+    }
+
+    if (all || name == "bullet")
+    {
+        b.spin("Threads", 1);
+        b.spin("Hash", 16);
+        b.add("ucinewgame");
+        b.game("go nodes 20000");
+        b.restore_options();
+    }
+
+    if (all || name == "endgame")
+    {
+        b.spin("Threads", 1);
+        b.spin("Hash", 16);
+        b.add("ucinewgame");
+
+        for (const auto& fen : EndgamePositions)
+            b.search("fen " + fen, "go depth 16");
+
+        b.restore_options();
+    }
+
+#if defined(HYP_FIXED_ZOBRIST)
+    if (all || name == "experience")
+    {
+        const std::string expFile  = ProfileExpFile;
+        const std::string bookFile = ProfileBookFile;
+
+        b.setup.scratchFiles = {expFile, expFile + ".bak", bookFile};
+
+        b.spin("Threads", 1);
+        b.spin("Hash", 16);
+        b.text("Experience File", expFile);
+        b.check("Experience Enabled", true);
+        b.check("Experience Readonly", false);
+        b.add("ucinewgame");
+
+        // Learn the line, then search it again with experience hits
+        b.game("go depth 10");
+        b.add("ucinewgame");
+        b.game("go depth 10");
+
+        // Root moves from the Experience Book
+        b.check("Experience Book", true);
+        b.spin("Experience Book Min Depth", Experience::MinDepth);
+        b.game("go depth 10");
+        b.check("Experience Book", false);
+
+        // Root moves from a Polyglot book built from the experience. Weights
+        // are move counts only, so every learned move gets an entry.
+        b.spin("Experience Book Eval Importance", 0);
+        b.add("exp_to_book " + bookFile + " 32 " + std::to_string(Experience::MinDepth));
+        b.text("Book1 File", bookFile);
+        b.check("Book1", true);
+        b.game("go depth 10");
+
+        b.restore_options();
+    }
+#endif
+
+    return b.setup;
+}
+
 // Builds a list of UCI commands to be run by bench. There
 // are five parameters: TT size in MB, number of search threads that
 // should be used, the limit value spent for each position, a file name
@@ -383,13 +598,19 @@ namespace Hypnos::Benchmark {
 // bench 64 1 100000 default nodes  : search default positions for 100K nodes each
 // bench 64 4 5000 current movetime : search current position with 4 threads for 5 sec
 // bench 16 1 5 blah perft          : run a perft 5 on positions in file "blah"
-std::vector<std::string> setup_bench(const std::string& currentFen, std::istream& is) {
+// bench profile=endgame            : run a named profile, see setup_bench_profile()
+BenchSetup setup_bench(const std::string& currentFen, const OptionsMap& options, std::istream& is) {
 
-    std::vector<std::string> fens, list;
+    BenchSetup               setup;
+    std::vector<std::string> fens, &list = setup.commands;
     std::string              go, token;
 
     // Assign default values to missing arguments
     std::string ttSize    = (is >> token) ? token : "16";
+
+    if (ttSize.rfind("profile=", 0) == 0)
+        return setup_bench_profile(ttSize.substr(8), currentFen, options);
+
     std::string threads   = (is >> token) ? token : "1";
     std::string limit     = (is >> token) ? token : "13";
     std::string fenFile   = (is >> token) ? token : "default";
@@ -403,6 +624,18 @@ std::vector<std::string> setup_bench(const std::string& currentFen, std::istream
     else if (fenFile == "current")
         fens.push_back(currentFen);
 
+    else if (is_packed_file(fenFile))
+    {
+        PositionList positions;
+
+        if (!read_positions(fenFile, positions))
+        {
+            std::cerr << "Unable to read packed file " << fenFile << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        setup.packed = std::move(positions.packed);
+    }
+
     else
     {
         std::string   fen;
@@ -434,7 +667,13 @@ std::vector<std::string> setup_bench(const std::string& currentFen, std::istream
             list.emplace_back(go);
         }
 
-    return list;
+    for (size_t i = 0; i < setup.packed.size(); ++i)
+    {
+        list.emplace_back("position packed " + std::to_string(i));
+        list.emplace_back(go);
+    }
+
+    return setup;
 }
 
 BenchmarkSetup setup_benchmark(std::istream& is) {
@@ -509,4 +748,164 @@ BenchmarkSetup setup_benchmark(std::istream& is) {
     return setup;
 }
 
-}  // namespace Hypnos
\ No newline at end of file
+Position& PositionList::set(size_t i, Position& pos, bool chess960, StateInfo* si) const {
+    return i < fens.size() ? pos.set(fens[i], chess960, si) : pos.set(packed[i - fens.size()], si);
+}
+
+std::string PositionList::fen(size_t i, bool chess960) const {
+    if (i < fens.size())
+        return fens[i];
+
+    StateInfo st;
+    Position  pos;
+    return set(i, pos, chess960, &st).fen();
+}
+
+bool is_packed_file(const std::string& file) {
+    char          header[sizeof(PackedFileHeader)];
+    std::ifstream in(file, std::ios::binary);
+
+    return in.read(header, sizeof(header))
+        && std::memcmp(header, PackedFileHeader, sizeof(header)) == 0;
+}
+
+bool read_positions(const std::string& file, PositionList& positions) {
+
+    MappedFile mf(file);
+
+    if (!mf.is_open())
+        return false;
+
+    const char*  data = mf.data();
+    const size_t size = mf.size();
+
+    if (size >= sizeof(PackedFileHeader)
+        && std::memcmp(data, PackedFileHeader, sizeof(PackedFileHeader)) == 0)
+    {
+        const size_t bytes = size - sizeof(PackedFileHeader);
+
+        if (bytes % sizeof(PackedPosition))
+            return false;
+
+        const size_t first = positions.packed.size();
+        positions.packed.resize(first + bytes / sizeof(PackedPosition));
+        std::memcpy(positions.packed.data() + first, data + sizeof(PackedFileHeader), bytes);
+        return true;
+    }
+
+    // EPD lines carry the first four FEN fields, move counters are optional.
+    // Lines are split in place in the mapped file.
+    for (size_t pos = 0; pos < size;)
+    {
+        size_t eol = std::string_view(data, size).find('\n', pos);
+        if (eol == std::string_view::npos)
+            eol = size;
+
+        std::string_view line(data + pos, eol - pos);
+        pos = eol + 1;
+
+        std::string_view fields[6];
+        size_t           count = 0;
+
+        for (size_t b = 0; count < 6;)
+        {
+            b = line.find_first_not_of(" \t\r", b);
+            if (b == std::string_view::npos)
+                break;
+
+            size_t e        = std::min(line.find_first_of(" \t\r", b), line.size());
+            fields[count++] = line.substr(b, e - b);
+            b               = e;
+        }
+
+        if (count < 4 || fields[0][0] == '#')
+            continue;
+
+        const auto digits = [](std::string_view f) {
+            return std::all_of(f.begin(), f.end(), ::isdigit);
+        };
+        const bool counters = count == 6 && digits(fields[4]) && digits(fields[5]);
+
+        std::string& fen = positions.fens.emplace_back();
+        for (size_t f = 0; f < 4; ++f)
+            fen.append(fields[f]).append(1, ' ');
+
+        if (counters)
+            fen.append(fields[4]).append(1, ' ').append(fields[5]);
+        else
+            fen += "0 1";
+    }
+    return true;
+}
+
+bool write_packed_positions(const std::string& file, const PositionList& positions, bool chess960) {
+
+    std::vector<PackedPosition> records(positions.size());
+    StateInfo                   st;
+    Position                    pos;
+
+    for (size_t i = 0; i < records.size(); ++i)
+        records[i] = i < positions.fens.size() ? positions.set(i, pos, chess960, &st).pack()
+                                               : positions.packed[i - positions.fens.size()];
+
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    out.write(PackedFileHeader, sizeof(PackedFileHeader));
+    out.write(reinterpret_cast<const char*>(records.data()),
+              std::streamsize(records.size() * sizeof(PackedPosition)));
+
+    return bool(out);
+}
+
+std::string position_format_speedtest(const std::vector<std::string>& fens, bool chess960) {
+
+    if (fens.empty())
+        return "No positions";
+
+    // Repeat the set so that each measurement covers about a million positions
+    const size_t reps  = std::max<size_t>(1, 1000000 / fens.size());
+    const size_t total = reps * fens.size();
+
+    std::vector<PackedPosition> packed(fens.size());
+    StateInfo                   st;
+    Position                    pos;
+    Key                         checksum = 0;
+    size_t                      fenBytes = 0;
+
+    for (size_t i = 0; i < fens.size(); ++i)
+    {
+        packed[i] = pos.set(fens[i], chess960, &st).pack();
+        fenBytes += fens[i].size() + 1;
+    }
+
+    auto measure = [&](auto&& body) {
+        TimePoint start = now();
+        for (size_t r = 0; r < reps; ++r)
+            for (size_t i = 0; i < fens.size(); ++i)
+                body(i);
+        TimePoint elapsed = std::max<TimePoint>(now() - start, 1);
+        return total * 1000 / size_t(elapsed);
+    };
+
+    size_t fenDecode = measure([&](size_t i) { checksum += pos.set(fens[i], chess960, &st).key(); });
+    size_t binDecode = measure([&](size_t i) { checksum += pos.set(packed[i], &st).key(); });
+    size_t fenEncode = measure([&](size_t i) {
+        pos.set(packed[i], &st);
+        checksum += pos.fen().size();
+    });
+    size_t binEncode = measure([&](size_t i) {
+        pos.set(packed[i], &st);
+        checksum += pos.pack().data[0];
+    });
+
+    std::ostringstream ss;
+    ss << "Positions: " << fens.size() << " x " << reps << "\n"
+       << "Size FEN / packed (bytes): " << fenBytes << " / "
+       << fens.size() * sizeof(PackedPosition) << "\n"
+       << "Decode positions/s FEN / packed: " << fenDecode << " / " << binDecode << "\n"
+       << "Set+encode positions/s FEN / packed: " << fenEncode << " / " << binEncode << "\n"
+       << "Checksum: " << std::hex << checksum << std::dec;
+
+    return ss.str();
+}
+
+}  // namespace Hypnos
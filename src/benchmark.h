@@ -19,13 +19,30 @@
 #ifndef BENCHMARK_H_INCLUDED
 #define BENCHMARK_H_INCLUDED
 
+#include <cstdint>
 #include <iosfwd>
 #include <string>
 #include <vector>
 
-namespace Hypnos::Benchmark {
+#include "position.h"
 
-std::vector<std::string> setup_bench(const std::string&, std::istream&);
+namespace Hypnos {
+
+class OptionsMap;
+
+namespace Benchmark {
+
+// Commands run by bench. Searches write experience only while the Experience
+// File is one of the scratch files, which are removed before and after the run.
+// 'position packed <i>' commands refer to the records of a packed position file.
+struct BenchSetup {
+    std::vector<std::string>    commands;
+    std::vector<std::string>    scratchFiles;
+    std::vector<PackedPosition> packed;
+};
+
+BenchSetup setup_bench(const std::string&, const OptionsMap&, std::istream&);
+BenchSetup setup_bench_profile(const std::string& name, const std::string&, const OptionsMap&);
 
 struct BenchmarkSetup {
     int                      ttSize;
@@ -37,6 +54,37 @@ struct BenchmarkSetup {
 
 BenchmarkSetup setup_benchmark(std::istream&);
 
+// Leaf move breakdown of 'go perft <depth> stats', as in the usual perft tables
+struct PerftStats {
+    uint64_t nodes, captures, enPassants, castles, promotions, checks, mates;
+};
+
+// Position files are either FEN/EPD text, one position per line, or packed
+// binary files: a PackedFileHeader followed by consecutive 32-byte records.
+// The records of packed files are kept as they are and set up directly, the
+// positions of text files are kept as FEN strings, and indices run over both.
+struct PositionList {
+    std::vector<std::string>    fens;
+    std::vector<PackedPosition> packed;
+
+    size_t      size() const { return fens.size() + packed.size(); }
+    Position&   set(size_t i, Position& pos, bool chess960, StateInfo* si) const;
+    std::string fen(size_t i, bool chess960) const;
+};
+
+// Magic string at the start of packed files, zero padded to one record so that
+// the records stay aligned in the mapped file.
+constexpr char PackedFileHeader[sizeof(PackedPosition)] = "HypnoS packed positions v1";
+
+bool is_packed_file(const std::string& file);
+bool read_positions(const std::string& file, PositionList& positions);
+bool write_packed_positions(const std::string& file, const PositionList& positions, bool chess960);
+
+// Encode/decode throughput of FEN versus PackedPosition on the given positions
+std::string position_format_speedtest(const std::vector<std::string>& fens, bool chess960);
+
+}  // namespace Benchmark
+
 }  // namespace Hypnos
 
 #endif  // #ifndef BENCHMARK_H_INCLUDED
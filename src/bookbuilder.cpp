@@ -0,0 +1,665 @@
+/*
+  HypnoS, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  HypnoS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  HypnoS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bookbuilder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "misc.h"
+#include "movegen.h"
+#include "polybook.h"
+#include "position.h"
+
+#if defined(HYP_FIXED_ZOBRIST)
+    #include "experience.h"
+#endif
+
+namespace Hypnos::BookBuilder {
+
+namespace {
+
+constexpr auto StartFEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Records buffered per worker before being sorted and spilled as a run
+constexpr size_t RunRecords = 1 << 22;
+
+// Records read ahead from each run while merging
+constexpr size_t MergeBufferRecords = 1 << 14;
+
+constexpr size_t GamesPerBatch = 4096;
+
+struct Record {
+    Key      key;
+    uint32_t weight;
+    uint16_t move;
+};
+
+bool operator<(const Record& a, const Record& b) {
+    return a.key != b.key ? a.key < b.key : a.move < b.move;
+}
+
+// How records of the same position and move coming from different workers or
+// runs are combined: games add up, experience walks may visit a position twice.
+enum class Combine {
+    Sum,
+    Max
+};
+
+uint32_t combine(Combine c, uint32_t a, uint32_t b) {
+    return c == Combine::Sum ? uint32_t(std::min<uint64_t>(uint64_t(a) + b, UINT32_MAX))
+                             : std::max(a, b);
+}
+
+// Castling is already "king captures rook", promotions start at knight == 1
+uint16_t polyglot_move(Move m) {
+    uint16_t pm = m.raw() & 0xFFF;
+
+    if (m.type_of() == PROMOTION)
+        pm |= (m.promotion_type() - 1) << 12;
+
+    return pm;
+}
+
+// Parallel external sort. Each worker fills its own buffer, full buffers are
+// sorted, combined and spilled to a temporary run file by the worker itself,
+// finish() merges all runs into the big-endian Polyglot book.
+class ExternalSorter {
+   public:
+    ExternalSorter(const std::string& book, Combine c, size_t workers) :
+        bookFile(book),
+        mode(c),
+        buffers(workers) {}
+
+    ~ExternalSorter() {
+        for (const auto& run : runs)
+            std::remove(run.c_str());
+    }
+
+    void add(size_t worker, Key key, Move m, uint32_t weight) {
+        auto& buf = buffers[worker];
+
+        if (buf.empty())
+            buf.reserve(RunRecords);
+
+        buf.push_back({key, weight, polyglot_move(m)});
+
+        if (buf.size() >= RunRecords)
+            spill(worker);
+    }
+
+    bool finish(size_t& positions, size_t& entries);
+
+   private:
+    void spill(size_t worker);
+
+    std::string                      bookFile;
+    Combine                          mode;
+    std::vector<std::vector<Record>> buffers;
+    std::vector<std::string>         runs;
+    std::mutex                       runsMutex;
+    std::atomic<bool>                failed{false};
+};
+
+void ExternalSorter::spill(size_t worker) {
+    auto& buf = buffers[worker];
+
+    if (buf.empty())
+        return;
+
+    std::sort(buf.begin(), buf.end());
+
+    size_t n = 0;
+    for (size_t i = 1; i < buf.size(); ++i)
+        if (buf[i].key == buf[n].key && buf[i].move == buf[n].move)
+            buf[n].weight = combine(mode, buf[n].weight, buf[i].weight);
+        else
+            buf[++n] = buf[i];
+
+    std::string run;
+    {
+        std::lock_guard<std::mutex> lock(runsMutex);
+        run = bookFile + ".run" + std::to_string(runs.size()) + ".tmp";
+        runs.push_back(run);
+    }
+
+    FILE* f = std::fopen(run.c_str(), "wb");
+    if (!f || std::fwrite(buf.data(), sizeof(Record), n + 1, f) != n + 1)
+        failed = true;
+    if (f)
+        std::fclose(f);
+
+    buf.clear();
+}
+
+bool ExternalSorter::finish(size_t& positions, size_t& entries) {
+    {
+        std::vector<std::thread> spillers;
+        for (size_t w = 0; w < buffers.size(); ++w)
+            spillers.emplace_back([this, w] { spill(w); });
+        for (auto& t : spillers)
+            t.join();
+    }
+
+    positions = entries = 0;
+
+    if (failed)
+        return false;
+
+    struct Reader {
+        FILE*               f = nullptr;
+        std::vector<Record> buf;
+        size_t              pos = 0;
+
+        bool next(Record& r) {
+            if (pos == buf.size())
+            {
+                buf.resize(MergeBufferRecords);
+                buf.resize(std::fread(buf.data(), sizeof(Record), buf.size(), f));
+                pos = 0;
+            }
+            return pos < buf.size() ? (r = buf[pos++], true) : false;
+        }
+    };
+
+    std::vector<Reader> readers(runs.size());
+    for (size_t i = 0; i < runs.size(); ++i)
+        if (!(readers[i].f = std::fopen(runs[i].c_str(), "rb")))
+            failed = true;
+
+    FILE* out = failed ? nullptr : std::fopen(bookFile.c_str(), "wb");
+
+    // Smallest head record of all runs first
+    using Head = std::pair<Record, size_t>;
+    auto later = [](const Head& a, const Head& b) { return b.first < a.first; };
+    std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+
+    if (out)
+        for (size_t i = 0; i < readers.size(); ++i)
+            if (Record r; readers[i].next(r))
+                heads.push({r, i});
+
+    std::vector<Record> group;
+
+    // Writes the moves of one position, best first, weights scaled to 16 bits
+    auto flush = [&] {
+        group.erase(std::remove_if(group.begin(), group.end(),
+                                   [](const Record& r) { return r.weight == 0; }),
+                    group.end());
+
+        if (group.empty())
+            return;
+
+        std::stable_sort(group.begin(), group.end(),
+                         [](const Record& a, const Record& b) { return a.weight > b.weight; });
+
+        uint64_t best = group[0].weight;
+
+        for (const Record& r : group)
+        {
+            uint64_t w = best > 0xFFFF ? std::max<uint64_t>(r.weight * 0xFFFFull / best, 1)
+                                       : r.weight;
+            uint8_t  bytes[16] = {};
+
+            for (int i = 0; i < 8; ++i)
+                bytes[i] = uint8_t(r.key >> (56 - 8 * i));
+            bytes[8]  = uint8_t(r.move >> 8);
+            bytes[9]  = uint8_t(r.move);
+            bytes[10] = uint8_t(w >> 8);
+            bytes[11] = uint8_t(w);
+
+            if (std::fwrite(bytes, 1, 16, out) != 16)
+                failed = true;
+        }
+
+        positions++;
+        entries += group.size();
+        group.clear();
+    };
+
+    while (!heads.empty())
+    {
+        auto [r, i] = heads.top();
+        heads.pop();
+
+        if (!group.empty() && group.back().key != r.key)
+            flush();
+
+        if (!group.empty() && group.back().move == r.move)
+            group.back().weight = combine(mode, group.back().weight, r.weight);
+        else
+            group.push_back(r);
+
+        if (Record nr; readers[i].next(nr))
+            heads.push({nr, i});
+    }
+
+    if (out)
+    {
+        flush();
+        failed = std::fclose(out) != 0 || failed;
+    }
+
+    for (auto& reader : readers)
+        if (reader.f)
+            std::fclose(reader.f);
+
+    return out && !failed;
+}
+
+enum GameResult {
+    WhiteWins,
+    BlackWins,
+    Draw,
+    Unknown
+};
+
+GameResult parse_result(const std::string& s) {
+    return s == "1-0"     ? WhiteWins
+         : s == "0-1"     ? BlackWins
+         : s == "1/2-1/2" ? Draw
+                          : Unknown;
+}
+
+// Value of a tag pair line, as in '[Result "1-0"]'
+std::string tag_value(const std::string& line) {
+    size_t first = line.find('"');
+    size_t last  = line.rfind('"');
+
+    return first != std::string::npos && last > first ? line.substr(first + 1, last - first - 1)
+                                                       : std::string();
+}
+
+struct PgnCounters {
+    std::atomic<size_t> games{0}, skipped{0}, errors{0}, moves{0};
+};
+
+// Parses one game (tag pairs followed by movetext) and adds its book moves
+void parse_game(const std::string& text,
+                int                maxPly,
+                ExternalSorter&    sorter,
+                size_t             worker,
+                PgnCounters&       counters) {
+
+    std::string fen = StartFEN;
+    GameResult  result = Unknown;
+    bool        standard = true;
+    size_t      i = 0;
+
+    // Tag pairs
+    while (i < text.size())
+    {
+        size_t eol  = text.find('\n', i);
+        auto   line = text.substr(i, eol == std::string::npos ? std::string::npos : eol - i);
+
+        if (line.empty() || line[0] != '[')
+            break;
+
+        if (line.compare(0, 8, "[Result ") == 0)
+            result = parse_result(tag_value(line));
+        else if (line.compare(0, 5, "[FEN ") == 0)
+            fen = tag_value(line);
+        else if (line.compare(0, 9, "[Variant ") == 0)
+        {
+            std::string variant = tag_value(line);
+            std::transform(variant.begin(), variant.end(), variant.begin(),
+                           [](unsigned char ch) { return char(std::tolower(ch)); });
+            standard = variant.empty() || variant == "standard";
+        }
+
+        i = eol == std::string::npos ? text.size() : eol + 1;
+    }
+
+    if (result == Unknown || !standard)
+    {
+        counters.skipped++;
+        return;
+    }
+
+    std::vector<StateInfo> states(size_t(maxPly) + 1);
+    Position               pos;
+    pos.set(fen, false, &states[0]);
+
+    int ply = 0;
+
+    // Movetext, skipping comments, variations, NAGs and move numbers
+    while (i < text.size() && ply < maxPly)
+    {
+        char c = text[i];
+
+        if (std::isspace((unsigned char) c) || c == ')' || c == '}')
+            ++i;
+        else if (c == '{')
+            i = std::min(text.find('}', i), text.size());
+        else if (c == ';')
+            i = std::min(text.find('\n', i), text.size());
+        else if (c == '(')
+        {
+            for (int depth = 0; i < text.size(); ++i)
+                if (text[i] == '(')
+                    depth++;
+                else if (text[i] == ')' && --depth == 0)
+                    break;
+        }
+        else
+        {
+            size_t end = i;
+            while (end < text.size() && !std::isspace((unsigned char) text[end])
+                   && !std::strchr("{}();", text[end]))
+                ++end;
+
+            std::string token = text.substr(i, end - i);
+            i                 = end;
+
+            if (token[0] == '$' || parse_result(token) != Unknown || token == "*")
+                continue;
+
+            // "12." or "12...Nf6". Numeric castling "0-0" carries no dot and is kept.
+            if (std::isdigit((unsigned char) token[0]))
+            {
+                if (size_t dot = token.rfind('.'); dot != std::string::npos)
+                    token.erase(0, dot + 1);
+                else if (token.find_first_not_of("0123456789") == std::string::npos)
+                    token.clear();
+
+                if (token.empty())
+                    continue;
+            }
+
+            Move m = san_to_move(pos, token);
+            if (m == Move::none())
+            {
+                counters.errors++;
+                break;
+            }
+
+            Color us = pos.side_to_move();
+            if (result == Draw || (result == WhiteWins) == (us == WHITE))
+                sorter.add(worker, Polyglot::compute_key(pos), m, result == Draw ? 1 : 2);
+
+            pos.do_move(m, states[++ply]);
+            counters.moves++;
+        }
+    }
+
+    counters.games++;
+}
+
+}  // namespace
+
+Move san_to_move(const Position& pos, std::string san) {
+
+    // Check, mate and annotation suffixes
+    while (!san.empty() && std::strchr("+#!?", san.back()))
+        san.pop_back();
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0")
+    {
+        bool kingSide = san.size() == 3;
+
+        for (const auto& m : MoveList<LEGAL>(pos))
+            if (m.type_of() == CASTLING && (m.to_sq() > m.from_sq()) == kingSide)
+                return m;
+
+        return Move::none();
+    }
+
+    PieceType pt    = PAWN;
+    PieceType promo = NO_PIECE_TYPE;
+    size_t    first = 0;
+
+    if (!san.empty() && std::strchr("PNBRQK", san[0]))
+        pt = PieceType(std::string(" PNBRQK").find(san[first++]));
+
+    if (size_t eq = san.find('='); eq != std::string::npos)
+    {
+        if (eq + 1 >= san.size() || !std::strchr("NBRQ", san[eq + 1]))
+            return Move::none();
+
+        promo = PieceType(std::string(" PNBRQK").find(san[eq + 1]));
+        san.resize(eq);
+    }
+    else if (pt == PAWN && !san.empty() && std::strchr("NBRQ", san.back()))
+    {
+        promo = PieceType(std::string(" PNBRQK").find(san.back()));
+        san.pop_back();
+    }
+
+    if (san.size() < first + 2)
+        return Move::none();
+
+    char tf = san[san.size() - 2], tr = san.back();
+    if (tf < 'a' || tf > 'h' || tr < '1' || tr > '8')
+        return Move::none();
+
+    Square to = make_square(File(tf - 'a'), Rank(tr - '1'));
+    int    df = -1, dr = -1;
+
+    // Disambiguation and capture marks
+    for (size_t j = first; j < san.size() - 2; ++j)
+        if (san[j] >= 'a' && san[j] <= 'h')
+            df = san[j] - 'a';
+        else if (san[j] >= '1' && san[j] <= '8')
+            dr = san[j] - '1';
+        else if (san[j] != 'x' && san[j] != ':' && san[j] != '-')
+            return Move::none();
+
+    for (const auto& m : MoveList<LEGAL>(pos))
+        if (m.type_of() != CASTLING && m.to_sq() == to && type_of(pos.moved_piece(m)) == pt
+            && (m.type_of() == PROMOTION ? m.promotion_type() : NO_PIECE_TYPE) == promo
+            && (df < 0 || file_of(m.from_sq()) == df) && (dr < 0 || rank_of(m.from_sq()) == dr))
+            return m;
+
+    return Move::none();
+}
+
+bool pgn_to_book(const std::string& pgnFile,
+                 const std::string& bookFile,
+                 int                maxPly,
+                 size_t             threads) {
+
+    std::ifstream in(pgnFile);
+    if (!in)
+    {
+        sync_cout << "info string Could not open " << pgnFile << sync_endl;
+        return false;
+    }
+
+    threads = std::max<size_t>(threads, 1);
+
+    ExternalSorter sorter(bookFile, Combine::Sum, threads);
+    PgnCounters    counters;
+    TimePoint      start = now();
+
+    std::vector<std::string> batch;
+    std::string              game, line;
+    bool                     inMoves = false;
+
+    // Parses the collected games, each worker takes a contiguous slice
+    auto run_batch = [&] {
+        std::vector<std::thread> workers;
+        size_t                   slice = (batch.size() + threads - 1) / threads;
+
+        for (size_t w = 0; w < threads && w * slice < batch.size(); ++w)
+            workers.emplace_back([&, w] {
+                for (size_t g = w * slice; g < std::min(batch.size(), (w + 1) * slice); ++g)
+                    parse_game(batch[g], maxPly, sorter, w, counters);
+            });
+
+        for (auto& t : workers)
+            t.join();
+
+        batch.clear();
+    };
+
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (!line.empty() && line[0] == '[' && inMoves)
+        {
+            batch.push_back(std::move(game));
+            game.clear();
+            inMoves = false;
+
+            if (batch.size() >= GamesPerBatch * threads)
+                run_batch();
+        }
+        else if (!line.empty() && line[0] != '[')
+            inMoves = true;
+
+        game += line;
+        game += '\n';
+    }
+
+    if (inMoves)
+        batch.push_back(std::move(game));
+    run_batch();
+
+    size_t positions, entries;
+    if (!sorter.finish(positions, entries))
+    {
+        sync_cout << "info string Could not write " << bookFile << sync_endl;
+        return false;
+    }
+
+    sync_cout << "info string " << counters.games << " games (" << counters.skipped
+              << " skipped, " << counters.errors << " with illegal moves), " << counters.moves
+              << " moves" << sync_endl;
+    sync_cout << "info string Book " << bookFile << ": " << positions << " positions, " << entries
+              << " moves in " << (now() - start) << " ms" << sync_endl;
+
+    return true;
+}
+
+#if defined(HYP_FIXED_ZOBRIST)
+
+namespace {
+
+struct ExpWalk {
+    int             maxPly, minDepth, evalImportance;
+    ExternalSorter& sorter;
+    size_t          worker;
+
+    std::unordered_set<Key> visited;
+    std::vector<StateInfo>  states;
+    size_t                  moves = 0;
+
+    // Experience moves worth a book entry, with their weights
+    std::vector<std::pair<Move, int>> book_moves(Position& pos) {
+        std::vector<std::pair<Move, int>> list;
+
+        for (auto* exp = Experience::probe(pos.key()); exp; exp = exp->next)
+            if (exp->depth >= minDepth && pos.pseudo_legal(exp->move) && pos.legal(exp->move))
+                if (int q = exp->quality(pos, evalImportance).first; q > 0)
+                    list.emplace_back(exp->move, q);
+
+        return list;
+    }
+
+    void add(Position& pos, Move m, int weight, int ply) {
+        sorter.add(worker, Polyglot::compute_key(pos), m, uint32_t(weight));
+        moves++;
+
+        pos.do_move(m, states[ply + 1]);
+        walk(pos, ply + 1);
+        pos.undo_move(m);
+    }
+
+    void walk(Position& pos, int ply) {
+        if (ply >= maxPly || !visited.insert(pos.key()).second)
+            return;
+
+        for (auto [m, weight] : book_moves(pos))
+            add(pos, m, weight, ply);
+    }
+};
+
+}  // namespace
+
+bool exp_to_book(const std::string& bookFile,
+                 int                maxPly,
+                 int                minDepth,
+                 int                evalImportance,
+                 size_t             threads) {
+
+    if (!Experience::enabled())
+    {
+        sync_cout << "info string Experience is not enabled" << sync_endl;
+        return false;
+    }
+
+    threads = std::max<size_t>(threads, 1);
+
+    ExternalSorter sorter(bookFile, Combine::Max, threads);
+    TimePoint      start = now();
+    size_t         moves = 0;
+    std::mutex     movesMutex;
+
+    // Root moves are dealt round robin, every worker walks its own subtrees.
+    // Transpositions between workers are merged by Combine::Max.
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < threads; ++w)
+        workers.emplace_back([&, w] {
+            ExpWalk  walker{maxPly, minDepth, evalImportance, sorter, w, {}, {}, 0};
+            Position pos;
+
+            walker.states.resize(size_t(maxPly) + 1);
+            pos.set(StartFEN, false, &walker.states[0]);
+
+            auto rootMoves = walker.book_moves(pos);
+            for (size_t i = w; i < rootMoves.size() && maxPly > 0; i += threads)
+                walker.add(pos, rootMoves[i].first, rootMoves[i].second, 0);
+
+            std::lock_guard<std::mutex> lock(movesMutex);
+            moves += walker.moves;
+        });
+
+    for (auto& t : workers)
+        t.join();
+
+    size_t positions, entries;
+    if (!sorter.finish(positions, entries))
+    {
+        sync_cout << "info string Could not write " << bookFile << sync_endl;
+        return false;
+    }
+
+    sync_cout << "info string " << moves << " experience moves walked" << sync_endl;
+    sync_cout << "info string Book " << bookFile << ": " << positions << " positions, " << entries
+              << " moves in " << (now() - start) << " ms" << sync_endl;
+
+    return true;
+}
+
+#endif
+
+}  // namespace Hypnos::BookBuilder
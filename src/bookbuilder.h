@@ -0,0 +1,60 @@
+/*
+  HypnoS, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  HypnoS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  HypnoS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOOKBUILDER_H_INCLUDED
+#define BOOKBUILDER_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+
+#include "types.h"
+
+namespace Hypnos {
+
+class Position;
+
+namespace BookBuilder {
+
+// Parses a move in Standard Algebraic Notation ("Nbd7", "exd8=Q+", "O-O"),
+// returns Move::none() if it is not a legal move in pos.
+Move san_to_move(const Position& pos, std::string san);
+
+// Builds a Polyglot book from the games of a PGN file. Every move played in
+// the first maxPly plies scores 2 for a win, 1 for a draw and 0 for a loss of
+// the side that played it. Games are parsed by 'threads' workers.
+bool pgn_to_book(const std::string& pgnFile,
+                 const std::string& bookFile,
+                 int                maxPly,
+                 size_t             threads);
+
+#if defined(HYP_FIXED_ZOBRIST)
+// Builds a Polyglot book from the loaded experience, following experience
+// moves of at least minDepth from the start position. Weights are the
+// positive ExpEntryEx::quality() of each move.
+bool exp_to_book(const std::string& bookFile,
+                 int                maxPly,
+                 int                minDepth,
+                 int                evalImportance,
+                 size_t             threads);
+#endif
+
+}  // namespace BookBuilder
+
+}  // namespace Hypnos
+
+#endif  // #ifndef BOOKBUILDER_H_INCLUDED
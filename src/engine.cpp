@@ -22,16 +22,20 @@
 #include <algorithm>  // std::max
 #include <optional>
 #include <cassert>
+#include <condition_variable>
 #include <deque>
 #include <iosfwd>
 #include <memory>
+#include <mutex>
 #include <ostream>
+#include <iomanip>
 #include <sstream>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 #include "evaluate.h"
+#include "memory.h"
 #include "misc.h"
 #include "nnue/network.h"
 #include "nnue/nnue_common.h"
@@ -77,21 +81,53 @@ constexpr auto StartFEN   = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq
 constexpr int  MaxHashMB  = Is64Bit ? 33554432 : 2048;
 int            MaxThreads = std::max(1024, 4 * int(get_hardware_concurrency()));
 
+// Options backed by process-wide state (networks, NUMA context, huge pages,
+// tablebases, books, experience, NNUE weight mode): only the main engine may
+// change them, sessions share whatever it set.
+constexpr std::string_view SharedOptions[] = {"Debug Log File",
+                                               "NumaPolicy",
+                                               "Huge Pages",
+                                               "EvalFile",
+                                               "EvalFileSmall",
+                                               "SyzygyPath",
+                                               "Book1 File",
+                                               "Book2 File",
+                                               "Experience Enabled",
+                                               "Experience File",
+                                               "Experience Readonly",
+                                               "NNUE Dynamic Weights",
+                                               "NNUE ManualWeights",
+                                               "NNUE StrategyMaterialWeight",
+                                               "NNUE StrategyPositionalWeight"};
+
 Engine::Engine(std::optional<std::string> path) :
+    Engine(path, nullptr) {}
+
+Engine::Engine(Engine& hostEngine) :
+    Engine(std::nullopt, &hostEngine) {}
+
+Engine::Engine(std::optional<std::string> path, Engine* hostEngine) :
+    host(hostEngine),
     binaryDirectory(path ? CommandLine::get_binary_directory(*path) : ""),
-    numaContext(NumaConfig::from_system()),
+    ownNumaContext(host ? nullptr
+                        : std::make_unique<NumaReplicationContext>(NumaConfig::from_system())),
+    numaContext(host ? host->numaContext : *ownNumaContext),
     states(new std::deque<StateInfo>(1)),
     threads(),
-    networks(
-      numaContext,
-      NN::Networks(
-        NN::NetworkBig({EvalFileDefaultNameBig, "None", ""}, NN::EmbeddedNNUEType::BIG),
-        NN::NetworkSmall({EvalFileDefaultNameSmall, "None", ""}, NN::EmbeddedNNUEType::SMALL))) {
+    ownNetworks(host ? nullptr
+                     : std::make_unique<LazyNumaReplicated<NN::Networks>>(
+                         numaContext,
+                         NN::Networks(NN::NetworkBig({EvalFileDefaultNameBig, "None", ""},
+                                                     NN::EmbeddedNNUEType::BIG),
+                                      NN::NetworkSmall({EvalFileDefaultNameSmall, "None", ""},
+                                                       NN::EmbeddedNNUEType::SMALL)))),
+    networks(host ? host->networks : *ownNetworks) {
     pos.set(StartFEN, false, &states->back());
 
 #ifdef HYP_FIXED_ZOBRIST
     // Bridge to allow experience.cpp to use Options["..."]
-    ::Experience::g_options = &options;
+    if (!host)
+        ::Experience::g_options = &options;
 #endif
 
     options.add(  //
@@ -113,12 +149,38 @@ Engine::Engine(std::optional<std::string> path) :
           return thread_allocation_information_as_string();
       }));
 
+    options.add(  //
+      "Wakeup Spin", Option(0, 0, 10000, [this](const Option& o) {
+          threads.set_spin_wait(o);
+          return std::nullopt;
+      }));
+
     options.add(  //
       "Hash", Option(16, 1, MaxHashMB, [this](const Option& o) {
           set_tt_size(o);
           return std::nullopt;
       }));
 
+    options.add(  //
+      "Huge Pages",
+      Option("Transparent var Transparent var 2MB var 1GB", "Transparent",
+             [this](const Option& o) {
+                 set_huge_page_policy(o == "1GB"   ? HugePagePolicy::Explicit1GB
+                                      : o == "2MB" ? HugePagePolicy::Explicit2MB
+                                                   : HugePagePolicy::Transparent);
+
+                 // Reallocate networks, Workers and TT with the new pages
+                 if (!host)
+                     networks.modify_and_replicate([](NN::Networks& networks_) {
+                         networks_ = NN::Networks(NN::NetworkBig(networks_.big),
+                                                  NN::NetworkSmall(networks_.small));
+                     });
+                 resize_threads();
+
+                 const std::string info = large_pages_info();
+                 return info.empty() ? std::nullopt : std::optional<std::string>(info);
+             }));
+
     options.add(  //
       "Clear Hash", Option([this](const Option&) {
           search_clear();
@@ -133,11 +195,15 @@ Engine::Engine(std::optional<std::string> path) :
 
     options.add("Skill Level", Option(20, 0, 20));
 
+    options.add("Tree Reuse", Option(false));
+
     // Time manager knobs
     options.add("Move Overhead",          Option(100, 0, 5000));   // ms
+    options.add("Adaptive Move Overhead", Option(false));
     options.add("Minimum Thinking Time",  Option(100, 0, 2000));   // ms
     options.add("Slow Mover",             Option(100, 10, 500));   // percent (100 = no change)
     options.add("nodestime", Option(0, 0, 10000));
+    options.add("Nodes Per Thread", Option(false));
 
     options.add("UCI_Chess960", Option(false));
 
@@ -156,6 +222,9 @@ Engine::Engine(std::optional<std::string> path) :
     // Debug: print NNUE weights once per search at root (main thread)
     options.add("NNUE Log Weights", Option(false));
 
+    // Hardware counters for bench and speedtest
+    options.add("Perf Counters", Option(false));
+
     // NNUE dynamic profile knobs removed: internal values are used instead
     // (Open 126/134, End 134/126, Complexity Gain = 10)
 
@@ -182,7 +251,11 @@ Engine::Engine(std::optional<std::string> path) :
 
     options.add("Book1 Depth", Option(255, 1, 350));
 
-    options.add("Book1 Width", Option(1, 1, 10));
+    options.add("Book1 Width", Option(1, 1, 10, [this](const Option& o) {
+        if (!host)
+            bookIndex.set_width(0, o);
+        return std::nullopt;
+      }));
 
     options.add("Book2", Option(false));
 
@@ -195,7 +268,11 @@ Engine::Engine(std::optional<std::string> path) :
 
     options.add("Book2 Depth", Option(255, 1, 350));
 
-    options.add("Book2 Width", Option(1, 1, 10));
+    options.add("Book2 Width", Option(1, 1, 10, [this](const Option& o) {
+        if (!host)
+            bookIndex.set_width(1, o);
+        return std::nullopt;
+      }));
 	
     //#ifdef HYP_FIXED_ZOBRIST
     // ===== HypnoS Experience UCI options =====
@@ -251,6 +328,8 @@ Engine::Engine(std::optional<std::string> path) :
                     return std::nullopt;
                 }));
 
+    options.add("Experience Guided Search", Option(false));
+
     //#endif
 
     options.add("Variety",
@@ -327,6 +406,23 @@ Engine::Engine(std::optional<std::string> path) :
                     return std::nullopt;
                 }));
 
+    for ([[maybe_unused]] auto name : SharedOptions)
+        assert(options.count(std::string(name)));
+
+    options.add_change_listener([this] { update_search_config(); });
+    update_search_config();
+
+    if (host)
+    {
+        // Shared tables are not safe for concurrent writers: sessions stay read-only
+        options.options_map["Experience Readonly"].currentValue = "true";
+        update_search_config();
+
+        host->sessions++;
+        resize_threads();
+        return;
+    }
+
     // Apply default NNUE mode according to current option defaults
     if (bool(options["NNUE ManualWeights"]))
         Hypnos::Eval::set_weights_mode(Hypnos::Eval::WeightsMode::Manual);
@@ -347,6 +443,24 @@ Engine::Engine(std::optional<std::string> path) :
 
     load_networks();
     resize_threads();
+
+    if (const std::string info = large_pages_info(); !info.empty())
+        sync_cout << "info string " << info << sync_endl;
+}
+
+Engine::~Engine() {
+    wait_for_search_finished();
+
+    if (host)
+        host->sessions--;
+}
+
+bool Engine::is_shared_option(const std::string& name) {
+    const std::string lowerName = UCIEngine::to_lower(name);
+
+    return std::any_of(std::begin(SharedOptions), std::end(SharedOptions), [&](auto shared) {
+        return UCIEngine::to_lower(std::string(shared)) == lowerName;
+    });
 }
 
 std::uint64_t Engine::perft(const std::string& fen, Depth depth, bool isChess960) {
@@ -355,13 +469,214 @@ std::uint64_t Engine::perft(const std::string& fen, Depth depth, bool isChess960
     return Benchmark::perft(fen, depth, isChess960);
 }
 
+Benchmark::PerftStats Engine::perft_stats(const std::string& fen, Depth depth, bool isChess960) {
+    verify_networks();
+
+    return Benchmark::perft_stats(fen, depth, isChess960);
+}
+
 void Engine::go(Search::LimitsType& limits) {
     assert(limits.perft == 0);
     verify_networks();
 
-    threads.start_thinking(options, pos, states, limits);
+    threads.start_thinking(*search_config(), pos, states, limits);
+}
+void Engine::stop() { threads.main_manager()->stop_search(threads); }
+
+// Partitions the thread budget into groups of threadsPerJob threads, each one
+// with its own root and SearchManager but sharing the TT and the networks, and
+// keeps every group busy with the next pending position. Results are reported
+// in completion order as soon as a group returns its bestmove.
+void Engine::analyze(const Benchmark::PositionList& positions,
+                     size_t                         threadsPerJob,
+                     const Search::LimitsType&      limits,
+                     const OnAnalysisResult&        onResult) {
+    assert(limits.perft == 0 && !limits.infinite && !limits.ponderMode);
+
+    wait_for_search_finished();
+    verify_networks();
+
+    if (!positions.size())
+        return;
+
+    struct SearchGroup {
+        Search::SearchManager::UpdateContext updates;
+        std::unique_ptr<ThreadPool>          ownPool;
+        ThreadPool*                          pool;
+        size_t                               job;
+        InfoFull                             last;
+        std::string                          pv, bound, bestmove;
+    };
+
+    const auto   config       = search_config();
+    const size_t totalThreads = options["Threads"];
+    const size_t jobThreads   = std::clamp(threadsPerJob, size_t(1), totalThreads);
+    const size_t groupCount   = std::min(totalThreads / jobThreads, positions.size());
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    std::deque<size_t>      finished;
+
+    // Group 0 reuses the engine thread pool, shrunk to the group size, so the
+    // overall number of threads stays within the 'Threads' option.
+    std::vector<std::unique_ptr<SearchGroup>> groups;
+
+    for (size_t g = 0; g < groupCount; ++g)
+    {
+        auto& grp = *groups.emplace_back(std::make_unique<SearchGroup>());
+
+        grp.updates.onUpdateNoMoves = [&grp](const InfoShort& info) {
+            grp.last       = InfoFull{};
+            grp.last.depth = info.depth;
+            grp.last.score = info.score;
+        };
+        grp.updates.onUpdateFull = [&grp](const InfoFull& info) {
+            if (info.multiPV != 1)
+                return;
+            grp.last  = info;
+            grp.pv    = info.pv;
+            grp.bound = info.bound;
+        };
+        grp.updates.onIter       = [](const InfoIter&) {};
+        grp.updates.onInfoString = [this, &grp](std::string_view str) {
+            updateContext.onInfoString("analysis " + std::to_string(grp.job + 1) + " "
+                                       + std::string(str));
+        };
+        grp.updates.onBestmove   = [&, g](std::string_view bestmove, std::string_view) {
+            groups[g]->bestmove = bestmove;
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                finished.push_back(g);
+            }
+            cv.notify_one();
+        };
+
+        if (g == 0)
+            grp.pool = &threads;
+        else
+        {
+            grp.ownPool = std::make_unique<ThreadPool>();
+            grp.pool    = grp.ownPool.get();
+        }
+
+        grp.pool->set(numaContext.get_numa_config(), {options, *grp.pool, tt, networks},
+                      grp.updates, jobThreads);
+        grp.pool->ensure_network_replicated();
+        grp.pool->main_manager()->ageTT = false;
+    }
+
+    // The groups share the TT, so it is aged once for the whole batch
+    tt.new_search();
+
+#ifdef HYP_FIXED_ZOBRIST
+    // Experience tables are not safe for concurrent writers, groups only read them
+    const bool wasPaused = ::Experience::is_learning_paused();
+    ::Experience::pause_learning();
+#endif
+
+    size_t next = 0, running = 0;
+
+    auto launch = [&](SearchGroup& grp) {
+        grp.job = next++;
+        grp.last = InfoFull{};
+        grp.pv.clear();
+        grp.bound.clear();
+        grp.bestmove.clear();
+
+        StateListPtr jobStates(new std::deque<StateInfo>(1));
+        Position     jobPos;
+        positions.set(grp.job, jobPos, options["UCI_Chess960"], &jobStates->back());
+
+        Search::LimitsType jobLimits = limits;
+        jobLimits.startTime          = now();
+
+        grp.pool->start_thinking(*config, jobPos, jobStates, jobLimits);
+        ++running;
+    };
+
+    for (auto& grp : groups)
+        launch(*grp);
+
+    while (running)
+    {
+        size_t g;
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            cv.wait(lk, [&] { return !finished.empty(); });
+            g = finished.front();
+            finished.pop_front();
+        }
+
+        auto& grp = *groups[g];
+        grp.pool->main_thread()->wait_for_search_finished();
+        --running;
+
+        grp.last.pv    = grp.pv;
+        grp.last.bound = grp.bound;
+        onResult(grp.job, grp.last, grp.bestmove);
+
+        if (next < positions.size())
+            launch(grp);
+    }
+
+#ifdef HYP_FIXED_ZOBRIST
+    if (!wasPaused)
+        ::Experience::resume_learning();
+#endif
+
+    // Give the engine pool back its original size and listeners
+    threads.set(numaContext.get_numa_config(), {options, threads, tt, networks}, updateContext,
+                options["Threads"]);
+    threads.ensure_network_replicated();
+}
+
+// Measures how long it takes from starting a search until all helper threads
+// run, on temporary pools of growing size, waking the helpers one by one and
+// through the fan-out tree. Uses the current 'Wakeup Spin' setting.
+std::string Engine::wakeup_benchmark(size_t maxThreads, int rounds) {
+    wait_for_search_finished();
+
+    std::stringstream ss;
+    ss << "Wakeup latency over " << rounds << " rounds, spin " << int(options["Wakeup Spin"])
+       << " us";
+
+    for (size_t n = 2; n <= maxThreads; n = n == maxThreads ? n + 1 : std::min(2 * n, maxThreads))
+    {
+        ThreadPool pool;
+        pool.set(numaContext.get_numa_config(), {options, pool, tt, networks}, updateContext, n);
+
+        double sequential = pool.wakeup_latency(rounds, false);
+        double fanOut     = pool.wakeup_latency(rounds, true);
+
+        ss << "\nthreads " << n << ": one by one " << std::fixed << std::setprecision(1)
+           << sequential / 1000 << " us, fan-out " << fanOut / 1000 << " us";
+    }
+
+    return ss.str();
+}
+
+void Engine::start_perf_counters() {
+    wait_for_search_finished();
+    perfCounters.clear();
+
+    // Counters follow the thread that opens them, so each search thread opens its own
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        perfCounters.push_back(std::make_unique<PerfCounters>());
+        threads.run_on_thread(i, [pc = perfCounters.back().get()] { pc->open(); });
+        threads.wait_on_thread(i);
+    }
+}
+
+PerfCounters::Totals Engine::stop_perf_counters() {
+    PerfCounters::Totals totals;
+
+    for (auto& pc : perfCounters)
+        totals += pc->read();
+
+    perfCounters.clear();
+    return totals;
 }
-void Engine::stop() { threads.stop = true; }
 
 void Engine::search_clear() {
     wait_for_search_finished();
@@ -369,8 +684,14 @@ void Engine::search_clear() {
     tt.clear(threads);
     threads.clear();
 
-    // @TODO wont work with multiple instances
-    Tablebases::init(options["SyzygyPath"]);  // Free mapped files
+    // Tablebases are process-wide, leave them alone while sessions may probe
+    if (!host && !sessions)
+        Tablebases::init(options["SyzygyPath"]);  // Free mapped files
+}
+
+void Engine::new_game() {
+    search_clear();
+    threads.gamesStarted++;
 }
 
 void Engine::set_on_update_no_moves(std::function<void(const Engine::InfoShort&)>&& f) {
@@ -389,6 +710,10 @@ void Engine::set_on_bestmove(std::function<void(std::string_view, std::string_vi
     updateContext.onBestmove = std::move(f);
 }
 
+void Engine::set_on_info_string(std::function<void(std::string_view)>&& f) {
+    updateContext.onInfoString = std::move(f);
+}
+
 void Engine::set_on_verify_networks(std::function<void(std::string_view)>&& f) {
     onVerifyNetworks = std::move(f);
 }
@@ -412,6 +737,11 @@ void Engine::set_position(const std::string& fen, const std::vector<std::string>
     }
 }
 
+void Engine::set_position(const PackedPosition& packed) {
+    states = StateListPtr(new std::deque<StateInfo>(1));
+    pos.set(packed, &states->back());
+}
+
 // modifiers
 
 void Engine::set_numa_config_from_option(const std::string& o) {
@@ -424,6 +754,11 @@ void Engine::set_numa_config_from_option(const std::string& o) {
         // Don't respect affinity set in the system.
         numaContext.set_numa_config(NumaConfig::from_system(false));
     }
+    else if (o == "l3")
+    {
+        // L3 cache domains within NUMA nodes, physical cores before SMT siblings
+        numaContext.set_numa_config(NumaConfig::from_cache_topology());
+    }
     else if (o == "none")
     {
         numaContext.set_numa_config(NumaConfig{});
@@ -440,7 +775,8 @@ void Engine::set_numa_config_from_option(const std::string& o) {
 
 void Engine::resize_threads() {
     threads.wait_for_search_finished();
-    threads.set(numaContext.get_numa_config(), {options, threads, tt, networks}, updateContext);
+    threads.set(numaContext.get_numa_config(), {options, threads, tt, networks}, updateContext,
+                options["Threads"]);
 
     // Reallocate the hash with the new threadpool size
     set_tt_size(options["Hash"]);
@@ -457,8 +793,10 @@ void Engine::set_ponderhit(bool b) { threads.main_manager()->ponder = b; }
 // network related
 
 void Engine::verify_networks() const {
-    networks->big.verify(options["EvalFile"], onVerifyNetworks);
-    networks->small.verify(options["EvalFileSmall"], onVerifyNetworks);
+    const OptionsMap& netOptions = host ? host->options : options;
+
+    networks->big.verify(netOptions["EvalFile"], onVerifyNetworks);
+    networks->small.verify(netOptions["EvalFileSmall"], onVerifyNetworks);
 }
 
 void Engine::load_networks() {
@@ -503,6 +841,15 @@ void Engine::trace_eval() const {
     sync_cout << "\n" << Eval::trace(p, *networks) << sync_endl;
 }
 
+std::shared_ptr<const Search::SearchConfig> Engine::search_config() const {
+    return std::atomic_load(&searchConfig);
+}
+
+// Rebuilds the option snapshot, a search already running keeps its own copy
+void Engine::update_search_config() {
+    std::atomic_store(&searchConfig, std::make_shared<const Search::SearchConfig>(options));
+}
+
 const OptionsMap& Engine::get_options() const { return options; }
 OptionsMap&       Engine::get_options() { return options; }
 
@@ -546,14 +893,26 @@ std::string Engine::thread_binding_information_as_string() const {
     if (boundThreadsByNode.empty())
         return ss.str();
 
-    bool isFirst = true;
+    const NumaConfig& cfg     = numaContext.get_numa_config();
+    bool              isFirst = true;
+    NumaIndex         n       = 0;
 
     for (auto&& [current, total] : boundThreadsByNode)
     {
         if (!isFirst)
             ss << ":";
         ss << current << "/" << total;
+
+        // L3 domains also show their physical cores and memory node
+        if (cfg.has_cache_domains())
+        {
+            const size_t cores = cfg.num_physical_cores_in_numa_node(n);
+            ss << " (" << cores << " cores" << (current <= cores ? ", no SMT" : "")
+               << ", NUMA " << cfg.replica_of(n) << ")";
+        }
+
         isFirst = false;
+        ++n;
     }
 
     return ss.str();
@@ -569,7 +928,8 @@ std::string Engine::thread_allocation_information_as_string() const {
     if (boundThreadsByNodeStr.empty())
         return ss.str();
 
-    ss << " with NUMA node thread binding: ";
+    ss << (numaContext.get_numa_config().has_cache_domains() ? " with L3 domain thread binding: "
+                                                               : " with NUMA node thread binding: ");
     ss << boundThreadsByNodeStr;
 
     return ss.str();
@@ -19,17 +19,21 @@
 #ifndef ENGINE_H_INCLUDED
 #define ENGINE_H_INCLUDED
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
+#include "benchmark.h"
 #include "nnue/network.h"
 #include "numa.h"
+#include "perfcounters.h"
 #include "position.h"
 #include "search.h"
 #include "syzygy/tbprobe.h"  // for Hypnos::Depth
@@ -45,27 +49,51 @@ class Engine {
     using InfoFull  = Search::InfoFull;
     using InfoIter  = Search::InfoIteration;
 
+    // Called by analyze() with the job index, its last PV line and the bestmove
+    using OnAnalysisResult = std::function<void(size_t, const InfoFull&, std::string_view)>;
+
     Engine(std::optional<std::string> path = std::nullopt);
 
+    // Session engine: it owns its options, TT and threads, while the networks, the
+    // NUMA context and the process-wide books, tablebases and experience tables
+    // are borrowed from the host engine, which must outlive it.
+    explicit Engine(Engine& host);
+
     // Cannot be movable due to components holding backreferences to fields
     Engine(const Engine&)            = delete;
     Engine(Engine&&)                 = delete;
     Engine& operator=(const Engine&) = delete;
     Engine& operator=(Engine&&)      = delete;
 
-    ~Engine() { wait_for_search_finished(); }
+    ~Engine();
 
     std::uint64_t perft(const std::string& fen, Depth depth, bool isChess960);
+    Benchmark::PerftStats perft_stats(const std::string& fen, Depth depth, bool isChess960);
 
     // non blocking call to start searching
     void go(Search::LimitsType&);
     // non blocking call to stop searching
     void stop();
 
+    // blocking call to search a batch of positions on independent thread groups
+    void analyze(const Benchmark::PositionList& positions,
+                 size_t                         threadsPerJob,
+                 const Search::LimitsType&      limits,
+                 const OnAnalysisResult&        onResult);
+
+    // blocking call, reports the helper thread wakeup latency up to maxThreads
+    std::string wakeup_benchmark(size_t maxThreads, int rounds);
+
+    // hardware counters of the search threads, for bench and speedtest
+    void                 start_perf_counters();
+    PerfCounters::Totals stop_perf_counters();
+
     // blocking call to wait for search to finish
     void wait_for_search_finished();
     // set a new position, moves are in UCI format
     void set_position(const std::string& fen, const std::vector<std::string>& moves);
+    // set a position from a packed position file record
+    void set_position(const PackedPosition& packed);
 
     // modifiers
 
@@ -74,12 +102,15 @@ class Engine {
     void set_tt_size(size_t mb);
     void set_ponderhit(bool);
     void search_clear();
+    // ucinewgame: clears the search state and counts the game
+    void new_game();
 
     void set_on_update_no_moves(std::function<void(const InfoShort&)>&&);
     void set_on_update_full(std::function<void(const InfoFull&)>&&);
     void set_on_iter(std::function<void(const InfoIter&)>&&);
     void set_on_bestmove(std::function<void(std::string_view, std::string_view)>&&);
     void set_on_verify_networks(std::function<void(std::string_view)>&&);
+    void set_on_info_string(std::function<void(std::string_view)>&&);
 
     // network related
 
@@ -107,21 +138,41 @@ class Engine {
     std::string                            thread_allocation_information_as_string() const;
     std::string                            thread_binding_information_as_string() const;
 
+    bool is_session() const { return host != nullptr; }
+
+    // Options backed by process-wide state, which sessions must not change
+    static bool is_shared_option(const std::string& name);
+
+    // Latest option snapshot, see Search::SearchConfig
+    std::shared_ptr<const Search::SearchConfig> search_config() const;
+
    private:
+    Engine(std::optional<std::string> path, Engine* hostEngine);
+
+    void update_search_config();
+
+    Engine* const     host;
+    std::atomic<int>  sessions{0};
     const std::string binaryDirectory;
 
-    NumaReplicationContext numaContext;
+    std::unique_ptr<NumaReplicationContext> ownNumaContext;
+    NumaReplicationContext&                 numaContext;
 
     Position     pos;
     StateListPtr states;
 
-    OptionsMap                               options;
-    ThreadPool                               threads;
+    OptionsMap                                  options;
+    std::shared_ptr<const Search::SearchConfig> searchConfig;
+    ThreadPool                                  threads;
     TranspositionTable                       tt;
-    LazyNumaReplicated<Eval::NNUE::Networks> networks;
+
+    std::unique_ptr<LazyNumaReplicated<Eval::NNUE::Networks>> ownNetworks;
+    LazyNumaReplicated<Eval::NNUE::Networks>&                 networks;
 
     Search::SearchManager::UpdateContext  updateContext;
     std::function<void(std::string_view)> onVerifyNetworks;
+
+    std::vector<std::unique_ptr<PerfCounters>> perfCounters;
 };
 
 }  // namespace Hypnos
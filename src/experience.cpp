@@ -16,6 +16,8 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <iostream>
 #include <iomanip>
@@ -27,6 +29,7 @@
 #include <condition_variable>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 #include <type_traits>
 #include "misc.h"
@@ -262,6 +265,133 @@ using ExpMap           = SugaRKeyMap<ExpEntryEx*>;
 using ExpIterator      = ExpMap::iterator;
 using ExpConstIterator = ExpMap::const_iterator;
 
+////////////////////////////////////////////////////////////////
+// Quality cache
+////////////////////////////////////////////////////////////////
+namespace {
+
+// Bumped after all entries are rescaled or freed. A quality value computed
+// under an older generation is never returned.
+std::atomic<u64> dataGeneration{0};
+
+void invalidate_quality_cache() { dataGeneration.fetch_add(1, std::memory_order_release); }
+
+// Per position generations, shared by the keys of a bucket and bumped after an
+// entry of the position is linked or merged. A cached quality value remembers
+// the buckets of the positions it read, so learning a PV only drops the values
+// that depended on it.
+constexpr usize  KeyGenerationBuckets = 1 << 16;
+std::atomic<u32> keyGeneration[KeyGenerationBuckets];
+
+u16 key_bucket(const Key k) { return u16(k >> 48); }
+
+void touch_quality_key(const Key k) {
+    keyGeneration[key_bucket(k)].fetch_add(1, std::memory_order_release);
+}
+
+// Positions read by one quality() call. The generation of each position is
+// read before its entries, so a value computed while that position changes
+// is stored with an already outdated stamp and never returned.
+struct QualityDeps {
+    static constexpr usize MaxDeps = 11;  // The root and up to ten plies ahead
+
+    void add(const Key k) {
+        assert(count < MaxDeps);
+        bucket[count++] = key_bucket(k);
+        stamp += keyGeneration[bucket[count - 1]].load(std::memory_order_acquire);
+    }
+
+    bool valid() const {
+        u64 current = 0;
+        for (usize i = 0; i < count; ++i)
+            current += keyGeneration[bucket[i]].load(std::memory_order_acquire);
+        return current == stamp;
+    }
+
+    u64   stamp = 0;
+    usize count = 0;
+    u16   bucket[MaxDeps];
+};
+
+// ExpEntryEx::quality() replays up to ten experience plies, so results are
+// memoized per (position and its reversible history, move, evalImportance).
+class QualityCache {
+   public:
+    using Result = std::pair<int, bool>;
+
+    bool probe(const Key k, Result& result, u64& generation) {
+        std::lock_guard lg(_mutex);
+
+        generation = dataGeneration.load(std::memory_order_acquire);
+        if (generation != _generation)
+        {
+            _table.clear();
+            _generation = generation;
+        }
+
+        const auto itr = _table.find(k);
+        if (itr == _table.end())
+            return false;
+
+        // A position it read was learned since
+        if (!itr->second.deps.valid())
+        {
+            _table.erase(itr);
+            return false;
+        }
+
+        result = itr->second.result;
+        return true;
+    }
+
+    void store(const Key k, const Result& result, const QualityDeps& deps, const u64 generation) {
+        std::lock_guard lg(_mutex);
+
+        // Data changed while the value was being computed
+        if (generation != _generation)
+            return;
+
+        if (_table.size() >= MaxEntries)
+            _table.clear();
+
+        _table[k] = {result, deps};
+    }
+
+   private:
+    struct Entry {
+        Result      result;
+        QualityDeps deps;
+    };
+
+    static constexpr usize MaxEntries = 1 << 16;
+
+    std::mutex                     _mutex;
+    std::unordered_map<Key, Entry> _table;
+    u64                            _generation = 0;
+};
+
+QualityCache qualityCache;
+
+// Draw detection inside quality() depends on the positions since the last
+// irreversible move and on the rule50 counter, so both are part of the key.
+Key quality_cache_key(const Position& pos, const ExpMove m, const int evalImportance) {
+    const StateInfo* st = pos.state();
+
+    Key k = pos.key() ^ (u64(m.raw()) << 32) ^ (u64(evalImportance) << 48)
+          ^ u64(st->rule50) * 0x9E3779B97F4A7C15ULL;
+
+    const int end = std::min(st->rule50, st->pliesFromNull);
+    for (int i = 0; i < end && st->previous; ++i)
+    {
+        st = st->previous;
+        k  = (k ^ st->key) * 0xFF51AFD7ED558CCDULL;
+    }
+
+    return k;
+}
+
+}
+
 ////////////////////////////////////////////////////////////////
 // ExpEntryEx::quality
 ////////////////////////////////////////////////////////////////
@@ -270,6 +400,16 @@ std::pair<int, bool> ExpEntryEx::quality(Position& pos, const int evalImportance
 
     assert(evalImportance >= 0 && evalImportance <= QualityEvalImportanceMax);
 
+    const Key            cacheKey = quality_cache_key(pos, move, evalImportance);
+    QualityCache::Result cached;
+    u64                  generation;
+
+    if (qualityCache.probe(cacheKey, cached, generation))
+        return cached;
+
+    QualityDeps deps;
+    deps.add(pos.key());
+
     // Draw detection
     bool maybeDraw = false;
 
@@ -317,6 +457,7 @@ std::pair<int, bool> ExpEntryEx::quality(Position& pos, const int evalImportance
                 break;
 
             // Probe the new position
+            deps.add(pos.key());
             temp1 = probe(pos.key());
 
             if (!temp1)
@@ -365,7 +506,10 @@ std::pair<int, bool> ExpEntryEx::quality(Position& pos, const int evalImportance
         pos.undo_move(move);
     }
 
-    return {q / QualityEvalImportanceMax, maybeDraw};
+    const QualityCache::Result result{q / QualityEvalImportanceMax, maybeDraw};
+    qualityCache.store(cacheKey, result, deps, generation);
+
+    return result;
 }
 
 // Experience data
@@ -417,6 +561,7 @@ class ExperienceData {
         _mainExp.clear();
         _oldExpData.clear();
         _expData.clear();
+        invalidate_quality_cache();
     }
 
     void clear_new_exp() {
@@ -430,6 +575,14 @@ class ExperienceData {
     }
 
     bool link_entry(ExpEntryEx* exp) {
+        const bool inserted = insert_entry(exp);
+
+        // Published after the change, see QualityDeps
+        touch_quality_key(exp->key);
+        return inserted;
+    }
+
+    bool insert_entry(ExpEntryEx* exp) {
         ExpIterator itr = _mainExp.find(exp->key);
 
         // If new entry: insert into map and continue
@@ -756,6 +909,9 @@ class ExperienceData {
                 }
             }
 
+            // Counts were scaled down
+            invalidate_quality_cache();
+
             sync_cout << "info string Saved " << allPositions << " position(s) and " << allMoves
                       << " moves to experience file: " << fn << sync_endl;
         }
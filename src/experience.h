@@ -20,12 +20,20 @@
 #define EXPERIENCE_H_INCLUDED
 
 #include "types.h"
+#include <algorithm>
 #include <atomic>
+#include <limits>
+#include <utility>
+
+namespace Hypnos {
+class Position;
+}
 
 //using namespace std;
 using u8    = std::uint8_t;
 using u16   = std::uint16_t;
 using u32   = std::uint32_t;
+using u64   = std::uint64_t;
 using usize = std::size_t;
 
 namespace Experience {
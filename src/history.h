@@ -165,6 +165,27 @@ using CorrectionHistory = typename Detail::CorrHistTypedef<T>::type;
 
 using TTMoveHistory = StatsEntry<std::int16_t, 8192>;
 
+// Histories groups the history tables of a search thread in one block, which
+// Search::Worker inherits first so that it starts its large page allocation.
+// Members are laid out by access pattern: the small tables read at every node
+// come first and share the leading page, then the big continuation tables and
+// last the pawn history, whose rows are picked at random by the pawn key.
+struct Histories {
+    // Resets all tables to their starting values, usually before a new game
+    void clear();
+
+    TTMoveHistory                   ttMoveHistory;
+    ButterflyHistory                mainHistory;
+    LowPlyHistory                   lowPlyHistory;
+    CapturePieceToHistory           captureHistory;
+    CorrectionHistory<Pawn>         pawnCorrectionHistory;
+    CorrectionHistory<Minor>        minorPieceCorrectionHistory;
+    CorrectionHistory<NonPawn>      nonPawnCorrectionHistory;
+    ContinuationHistory             continuationHistory[2][2];
+    CorrectionHistory<Continuation> continuationCorrectionHistory;
+    PawnHistory                     pawnHistory;
+};
+
 }  // namespace Hypnos
 
 #endif  // #ifndef HISTORY_H_INCLUDED
@@ -18,7 +18,12 @@
 
 #include "memory.h"
 
+#include <atomic>
 #include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
 
 #if __has_include("features.h")
     #include <features.h>
@@ -26,6 +31,12 @@
 
 #if defined(__linux__) && !defined(__ANDROID__)
     #include <sys/mman.h>
+    #if defined(MAP_HUGETLB)
+        #define HUGETLBALLOC
+        #ifndef MAP_HUGE_SHIFT
+            #define MAP_HUGE_SHIFT 26
+        #endif
+    #endif
 #endif
 
 #if defined(__APPLE__) || defined(__ANDROID__) || defined(__OpenBSD__) \
@@ -191,10 +202,77 @@ void* aligned_large_pages_alloc(size_t allocSize) {
     return mem;
 }
 
+// Windows large pages are always tried first, there is nothing to choose
+void set_huge_page_policy(HugePagePolicy) {}
+
 #else
 
+namespace {
+
+std::atomic<HugePagePolicy> hugePagePolicy{HugePagePolicy::Transparent};
+
+// Live allocations of aligned_large_pages_alloc() with the page size backing
+// them, 0 for memory from std_aligned_alloc(). Needed to release hugetlbfs
+// mappings with munmap() and to report the page sizes actually obtained.
+struct LargePageRegistry {
+    struct Allocation {
+        size_t size;
+        size_t pageSize;
+    };
+
+    std::mutex                              mutex;
+    std::unordered_map<void*, Allocation> allocations;
+};
+
+LargePageRegistry& registry() {
+    static LargePageRegistry r;
+    return r;
+}
+
+    #if defined(HUGETLBALLOC)
+constexpr size_t HugePage2MB = size_t(2) << 20;
+constexpr size_t HugePage1GB = size_t(1) << 30;
+
+// Maps explicit hugetlbfs pages of the given size, nullptr if the kernel has
+// no such pages reserved (see /sys/kernel/mm/hugepages).
+void* hugetlb_alloc(size_t size, size_t pageSize) {
+
+    const int sizeFlag = (pageSize == HugePage1GB ? 30 : 21) << MAP_HUGE_SHIFT;
+    void*     mem = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | sizeFlag, -1, 0);
+
+    return mem == MAP_FAILED ? nullptr : mem;
+}
+    #endif
+
+}  // namespace
+
+void set_huge_page_policy(HugePagePolicy policy) { hugePagePolicy = policy; }
+
 void* aligned_large_pages_alloc(size_t allocSize) {
 
+    #if defined(HUGETLBALLOC)
+    // Explicit pages first: 1GB pages only for allocations of at least 1GB, so
+    // that Workers and networks do not waste most of a scarce gigantic page.
+    const HugePagePolicy policy = hugePagePolicy;
+
+    for (size_t pageSize : {HugePage1GB, HugePage2MB})
+    {
+        if (policy == HugePagePolicy::Transparent
+            || (pageSize == HugePage1GB
+                && (policy != HugePagePolicy::Explicit1GB || allocSize < HugePage1GB)))
+            continue;
+
+        size_t size = ((allocSize + pageSize - 1) / pageSize) * pageSize;
+        if (void* mem = hugetlb_alloc(size, pageSize))
+        {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            registry().allocations[mem] = {size, pageSize};
+            return mem;
+        }
+    }
+    #endif
+
     #if defined(__linux__)
     constexpr size_t alignment = 2 * 1024 * 1024;  // 2MB page size assumed
     #else
@@ -207,6 +285,12 @@ void* aligned_large_pages_alloc(size_t allocSize) {
     #if defined(MADV_HUGEPAGE)
     madvise(mem, size, MADV_HUGEPAGE);
     #endif
+
+    if (mem)
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        registry().allocations[mem] = {size, 0};
+    }
     return mem;
 }
 
@@ -262,7 +346,71 @@ void aligned_large_pages_free(void* mem) {
 
 #else
 
-void aligned_large_pages_free(void* mem) { std_aligned_free(mem); }
+void aligned_large_pages_free(void* mem) {
+
+    if (!mem)
+        return;
+
+    LargePageRegistry::Allocation a{0, 0};
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        auto                        it = registry().allocations.find(mem);
+        if (it != registry().allocations.end())
+        {
+            a = it->second;
+            registry().allocations.erase(it);
+        }
+    }
+
+    #if defined(HUGETLBALLOC)
+    if (a.pageSize)
+    {
+        munmap(mem, a.size);
+        return;
+    }
+    #endif
+
+    std_aligned_free(mem);
+}
+
+#endif
+
+// Describes the policy and how much of the live large page memory ended up
+// on each page size. Empty on Windows, where the option has no effect.
+std::string large_pages_info() {
+
+#if defined(_WIN32)
+
+    return "";
+
+#else
+
+    size_t mb1GB = 0, mb2MB = 0, mbOther = 0;
+    {
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        for (const auto& [mem, a] : registry().allocations)
+            (a.pageSize == size_t(1) << 30 ? mb1GB
+             : a.pageSize                  ? mb2MB
+                                           : mbOther) += a.size;
+    }
+
+    const HugePagePolicy policy = hugePagePolicy;
+    const char*          other  = has_large_pages() ? " MB on transparent pages" : " MB on small pages";
+
+    std::stringstream ss;
+    ss << "Huge Pages: "
+       << (policy == HugePagePolicy::Explicit1GB   ? "1GB"
+           : policy == HugePagePolicy::Explicit2MB ? "2MB"
+                                                   : "Transparent")
+       << " requested, ";
+    if (mb1GB)
+        ss << ((mb1GB + (1 << 20) - 1) >> 20) << " MB on 1 GB pages, ";
+    if (mb2MB)
+        ss << ((mb2MB + (1 << 20) - 1) >> 20) << " MB on 2 MB pages, ";
+    ss << ((mbOther + (1 << 20) - 1) >> 20) << other;
+
+    return ss.str();
 
 #endif
+}
 }  // namespace Hypnos
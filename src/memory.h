@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <memory>
 #include <new>
+#include <string>
 #include <type_traits>
 #include <utility>
 
@@ -40,6 +41,18 @@ void  aligned_large_pages_free(void* mem);
 
 bool has_large_pages();
 
+// Which pages aligned_large_pages_alloc() asks for on Linux: the default
+// madvise() hint for transparent huge pages, or explicit hugetlbfs pages that
+// fall back to the former when the kernel has none reserved.
+enum class HugePagePolicy {
+    Transparent,
+    Explicit2MB,
+    Explicit1GB
+};
+
+void        set_huge_page_policy(HugePagePolicy policy);
+std::string large_pages_info();
+
 // Frees memory which was placed there with placement new.
 // Works for both single objects and arrays of unknown bound.
 template<typename T, typename FREE_FUNC>
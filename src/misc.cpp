@@ -36,6 +36,14 @@
 #include "types.h"
 #include "position.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define HAS_MMAP
+#endif
+
 namespace Hypnos {
 
 namespace {
@@ -472,6 +480,53 @@ std::optional<std::string> read_file_to_string(const std::string& path) {
     return std::string(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
 }
 
+MappedFile::MappedFile(const std::string& path) {
+#ifdef HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat sb;
+    if (::fstat(fd, &sb) == 0)
+    {
+        isOpen = true;
+        len    = size_t(sb.st_size);
+
+        if (len)
+        {
+            void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
+            {
+                ::madvise(p, len, MADV_SEQUENTIAL);
+                ptr    = static_cast<const char*>(p);
+                mapped = true;
+            }
+        }
+    }
+    ::close(fd);
+
+    if (!isOpen || mapped || !len)
+        return;
+#endif
+
+    // No mapping available, fall back to reading the whole file
+    auto content = read_file_to_string(path);
+    if (!content)
+        return;
+
+    buffer = std::move(*content);
+    ptr    = buffer.data();
+    len    = buffer.size();
+    isOpen = true;
+}
+
+MappedFile::~MappedFile() {
+#ifdef HAS_MMAP
+    if (mapped)
+        ::munmap(const_cast<char*>(ptr), len);
+#endif
+}
+
 void remove_whitespace(std::string& s) {
     s.erase(std::remove_if(s.begin(), s.end(), [](char c) { return std::isspace(c); }), s.end());
 }
@@ -69,6 +69,28 @@ struct PipeDeleter {
 // Returns std::nullopt if the file does not exist.
 std::optional<std::string> read_file_to_string(const std::string& path);
 
+// Read-only view of a whole file. The file is memory mapped where the platform
+// supports it, otherwise it is read into memory.
+class MappedFile {
+   public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool        is_open() const { return isOpen; }
+    const char* data() const { return ptr; }
+    size_t      size() const { return len; }
+
+   private:
+    const char* ptr    = nullptr;
+    size_t      len    = 0;
+    bool        isOpen = false;
+    bool        mapped = false;
+    std::string buffer;
+};
+
 void dbg_hit_on(bool cond, int slot = 0);
 void dbg_mean_of(int64_t value, int slot = 0);
 void dbg_stdev_of(int64_t value, int slot = 0);
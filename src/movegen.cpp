@@ -18,6 +18,7 @@
 
 #include "movegen.h"
 
+#include <algorithm>
 #include <cassert>
 #include <initializer_list>
 
@@ -26,7 +27,6 @@
 
 #if defined(USE_AVX512ICL)
     #include <array>
-    #include <algorithm>
     #include <immintrin.h>
 #endif
 
@@ -260,6 +260,161 @@ Move* generate_all(const Position& pos, Move* moveList) {
     return moveList;
 }
 
+
+#if defined(USE_LEGAL_MOVEGEN)
+
+// Pawn moves of the given pawns whose destination is in pushMask (pushes) or
+// captureMask (captures). En passant is left to the caller.
+template<Color Us>
+Move* legal_pawn_moves(const Position& pos,
+                       Move*           moveList,
+                       Bitboard        pawns,
+                       Bitboard        pushMask,
+                       Bitboard        captureMask) {
+
+    constexpr Bitboard  TRank7BB = (Us == WHITE ? Rank7BB : Rank2BB);
+    constexpr Bitboard  TRank3BB = (Us == WHITE ? Rank3BB : Rank6BB);
+    constexpr Direction Up       = pawn_push(Us);
+    constexpr Direction UpRight  = (Us == WHITE ? NORTH_EAST : SOUTH_WEST);
+    constexpr Direction UpLeft   = (Us == WHITE ? NORTH_WEST : SOUTH_EAST);
+
+    const Bitboard emptySquares = ~pos.pieces();
+    const Bitboard enemies      = pos.pieces(~Us) & captureMask;
+
+    Bitboard pawnsOn7    = pawns & TRank7BB;
+    Bitboard pawnsNotOn7 = pawns & ~TRank7BB;
+
+    Bitboard b1 = shift<Up>(pawnsNotOn7) & emptySquares;
+    Bitboard b2 = shift<Up>(b1 & TRank3BB) & emptySquares & pushMask;
+
+    moveList = splat_pawn_moves<Up>(moveList, b1 & pushMask);
+    moveList = splat_pawn_moves<Up + Up>(moveList, b2);
+
+    if (pawnsOn7)
+    {
+        b1 = shift<UpRight>(pawnsOn7) & enemies;
+        b2 = shift<UpLeft>(pawnsOn7) & enemies;
+        Bitboard b3 = shift<Up>(pawnsOn7) & emptySquares & pushMask;
+
+        while (b1)
+            moveList = make_promotions<NON_EVASIONS, UpRight, true>(moveList, pop_lsb(b1));
+
+        while (b2)
+            moveList = make_promotions<NON_EVASIONS, UpLeft, true>(moveList, pop_lsb(b2));
+
+        while (b3)
+            moveList = make_promotions<NON_EVASIONS, Up, false>(moveList, pop_lsb(b3));
+    }
+
+    moveList = splat_pawn_moves<UpRight>(moveList, shift<UpRight>(pawnsNotOn7) & enemies);
+    moveList = splat_pawn_moves<UpLeft>(moveList, shift<UpLeft>(pawnsNotOn7) & enemies);
+
+    return moveList;
+}
+
+
+template<Color Us, PieceType Pt>
+Move* legal_piece_moves(const Position& pos, Move* moveList, Bitboard pieces, Bitboard target) {
+
+    const Square   ksq    = pos.square<KING>(Us);
+    const Bitboard pinned = pos.blockers_for_king(Us);
+
+    while (pieces)
+    {
+        Square   from = pop_lsb(pieces);
+        Bitboard b    = attacks_bb<Pt>(from, pos.pieces()) & target;
+
+        if (pinned & from)
+            b &= line_bb(ksq, from);
+
+        moveList = splat_moves(moveList, from, b);
+    }
+
+    return moveList;
+}
+
+
+// Generates legal moves directly: the pin and check masks are computed once,
+// so only en passant captures still go through Position::legal().
+template<Color Us>
+Move* generate_legal(const Position& pos, Move* moveList) {
+
+    constexpr Color Them = ~Us;
+
+    const Square   ksq      = pos.square<KING>(Us);
+    const Bitboard checkers = pos.checkers();
+    const Bitboard pinned   = pos.blockers_for_king(Us) & pos.pieces(Us);
+
+    if (!more_than_one(checkers))
+    {
+        // Non-king moves must capture the checker or block the check, and pinned
+        // pieces stay on the line through the king. This also holds for pieces
+        // that only look pinned because the checking slider is in between.
+        const Bitboard checkMask = checkers ? between_bb(ksq, lsb(checkers)) : ~Bitboard(0);
+        const Bitboard target    = ~pos.pieces(Us) & checkMask;
+
+        Bitboard pawns = pos.pieces(Us, PAWN);
+
+        moveList = legal_pawn_moves<Us>(pos, moveList, pawns & ~pinned, checkMask, checkMask);
+
+        for (Bitboard b = pawns & pinned; b;)
+        {
+            Square   from = pop_lsb(b);
+            Bitboard mask = line_bb(ksq, from) & checkMask;
+            moveList      = legal_pawn_moves<Us>(pos, moveList, square_bb(from), mask, mask);
+        }
+
+        if (pos.ep_square() != SQ_NONE)
+            for (Bitboard b = pawns & attacks_bb<PAWN>(pos.ep_square(), Them); b;)
+            {
+                Move m = Move::make<EN_PASSANT>(pop_lsb(b), pos.ep_square());
+                if (pos.legal(m))
+                    *moveList++ = m;
+            }
+
+        // A pinned knight can never move
+        moveList =
+          legal_piece_moves<Us, KNIGHT>(pos, moveList, pos.pieces(Us, KNIGHT) & ~pinned, target);
+        moveList = legal_piece_moves<Us, BISHOP>(pos, moveList, pos.pieces(Us, BISHOP), target);
+        moveList = legal_piece_moves<Us, ROOK>(pos, moveList, pos.pieces(Us, ROOK), target);
+        moveList = legal_piece_moves<Us, QUEEN>(pos, moveList, pos.pieces(Us, QUEEN), target);
+    }
+
+    // Squares attacked by the opponent. Our king is removed from the occupancy
+    // so that it cannot step back along the ray of a checking slider.
+    const Bitboard occupied = pos.pieces() ^ ksq;
+    Bitboard       attacked =
+      pawn_attacks_bb<Them>(pos.pieces(Them, PAWN)) | attacks_bb<KING>(pos.square<KING>(Them));
+
+    for (Bitboard b = pos.pieces(Them, KNIGHT); b;)
+        attacked |= attacks_bb<KNIGHT>(pop_lsb(b));
+
+    for (Bitboard b = pos.pieces(Them, BISHOP, QUEEN); b;)
+        attacked |= attacks_bb<BISHOP>(pop_lsb(b), occupied);
+
+    for (Bitboard b = pos.pieces(Them, ROOK, QUEEN); b;)
+        attacked |= attacks_bb<ROOK>(pop_lsb(b), occupied);
+
+    moveList = splat_moves(moveList, ksq, attacks_bb<KING>(ksq) & ~pos.pieces(Us) & ~attacked);
+
+    if (!checkers && pos.can_castle(Us & ANY_CASTLING))
+        for (CastlingRights cr : {Us & KING_SIDE, Us & QUEEN_SIDE})
+            if (!pos.castling_impeded(cr) && pos.can_castle(cr))
+            {
+                Square rsq = pos.castling_rook_square(cr);
+                Square kto = relative_square(Us, cr & KING_SIDE ? SQ_G1 : SQ_C1);
+
+                // In Chess960 the castling rook may be shielding the king
+                if (!(between_bb(ksq, kto) & attacked)
+                    && !(pos.is_chess960() && (pos.blockers_for_king(Us) & rsq)))
+                    *moveList++ = Move::make<CASTLING>(ksq, rsq);
+            }
+
+    return moveList;
+}
+
+#endif
+
 }  // namespace
 
 
@@ -287,10 +442,13 @@ template Move* generate<QUIETS>(const Position&, Move*);
 template Move* generate<EVASIONS>(const Position&, Move*);
 template Move* generate<NON_EVASIONS>(const Position&, Move*);
 
-// generate<LEGAL> generates all the legal moves in the given position
+// generate<LEGAL> generates all the legal moves in the given position. With
+// USE_LEGAL_MOVEGEN they are generated legal by construction, otherwise the
+// pseudo-legal moves are filtered.
 
-template<>
-Move* generate<LEGAL>(const Position& pos, Move* moveList) {
+namespace {
+
+[[maybe_unused]] Move* generate_legal_filtered(const Position& pos, Move* moveList) {
 
     Color    us     = pos.side_to_move();
     Bitboard pinned = pos.blockers_for_king(us) & pos.pieces(us);
@@ -309,4 +467,28 @@ Move* generate<LEGAL>(const Position& pos, Move* moveList) {
     return moveList;
 }
 
+}  // namespace
+
+template<>
+Move* generate<LEGAL>(const Position& pos, Move* moveList) {
+
+#if defined(USE_LEGAL_MOVEGEN)
+    Move* last = pos.side_to_move() == WHITE ? generate_legal<WHITE>(pos, moveList)
+                                             : generate_legal<BLACK>(pos, moveList);
+
+    #ifndef NDEBUG
+    // Debug builds cross-check both generators, so perft validates the new one
+    Move  filtered[MAX_MOVES];
+    Move* end = generate_legal_filtered(pos, filtered);
+    assert(end - filtered == last - moveList);
+    for (Move* m = filtered; m != end; ++m)
+        assert(std::find(moveList, last, *m) != last);
+    #endif
+
+    return last;
+#else
+    return generate_legal_filtered(pos, moveList);
+#endif
+}
+
 }  // namespace Hypnos
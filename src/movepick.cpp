@@ -19,6 +19,7 @@
 #include "movepick.h"
 
 #include <cassert>
+#include <cstdint>
 #include <limits>
 #include <utility>
 
@@ -128,15 +129,76 @@ ExtMove* MovePicker::score(MoveList<Type>& ml) {
 
     Color us = pos.side_to_move();
 
-    [[maybe_unused]] Bitboard threatByLesser[KING + 1];
     if constexpr (Type == QUIETS)
     {
+        Bitboard threatByLesser[KING + 1];
         threatByLesser[PAWN]   = 0;
         threatByLesser[KNIGHT] = threatByLesser[BISHOP] = pos.attacks_by<PAWN>(~us);
         threatByLesser[ROOK] =
           pos.attacks_by<KNIGHT>(~us) | pos.attacks_by<BISHOP>(~us) | threatByLesser[KNIGHT];
         threatByLesser[QUEEN] = pos.attacks_by<ROOK>(~us) | threatByLesser[ROOK];
         threatByLesser[KING]  = pos.attacks_by<QUEEN>(~us) | threatByLesser[QUEEN];
+
+        // Quiets are scored in passes over arrays of indices. The first pass
+        // does the position dependent work, the second only gathers from the
+        // history rows that are fixed for this node, and SEE is computed last,
+        // for checking moves only.
+        const auto* mainRow = (*mainHistory)[us].data();
+        const auto* pawnRow = (*pawnHistory)[pawn_history_index(pos)][0].data();
+        const auto* ch0     = (*continuationHistory[0])[0].data();
+        const auto* ch1     = (*continuationHistory[1])[0].data();
+        const auto* ch2     = (*continuationHistory[2])[0].data();
+        const auto* ch3     = (*continuationHistory[3])[0].data();
+        const auto* ch5     = (*continuationHistory[5])[0].data();
+
+        std::uint16_t fromTo[MAX_MOVES], pieceTo[MAX_MOVES];
+        ExtMove*      checks[MAX_MOVES];
+        size_t        n = 0, checkCount = 0;
+
+        for (auto move : ml)
+        {
+            ExtMove& m = cur[n];
+            m          = move;
+
+            const Square    from = m.from_sq();
+            const Square    to   = m.to_sq();
+            const Piece     pc   = pos.moved_piece(m);
+            const PieceType pt   = type_of(pc);
+
+            fromTo[n]  = std::uint16_t(m.from_to());
+            pieceTo[n] = std::uint16_t(pc * SQUARE_NB + to);
+
+            if (pos.check_squares(pt) & to)
+                checks[checkCount++] = &m;
+
+            // penalty for moving to a square threatened by a lesser piece
+            // or bonus for escaping an attack by a lesser piece.
+            static constexpr int bonus[KING + 1] = {0, 0, 144, 144, 256, 517, 10000};
+            int v = threatByLesser[pt] & to ? -95 : 100 * bool(threatByLesser[pt] & from);
+            m.value = bonus[pt] * v;
+            ++n;
+        }
+
+        // histories
+        for (size_t i = 0; i < n; ++i)
+        {
+            const size_t pt = pieceTo[i];
+            cur[i].value += 2 * mainRow[fromTo[i]] + 2 * pawnRow[pt] + ch0[pt] + ch1[pt]
+                          + ch2[pt] + ch3[pt] + ch5[pt];
+        }
+
+        if (ply < LOW_PLY_HISTORY_SIZE)
+        {
+            const auto& lowPlyRow = (*lowPlyHistory)[ply];
+            for (size_t i = 0; i < n; ++i)
+                cur[i].value += 8 * lowPlyRow[fromTo[i]] / (1 + ply);
+        }
+
+        // bonus for checks
+        for (size_t i = 0; i < checkCount; ++i)
+            checks[i]->value += pos.see_ge(*checks[i], -75) * 16384;
+
+        return cur + n;
     }
 
     ExtMove* it = cur;
@@ -145,7 +207,6 @@ ExtMove* MovePicker::score(MoveList<Type>& ml) {
         ExtMove& m = *it++;
         m          = move;
 
-        const Square    from          = m.from_sq();
         const Square    to            = m.to_sq();
         const Piece     pc            = pos.moved_piece(m);
         const PieceType pt            = type_of(pc);
@@ -155,31 +216,6 @@ ExtMove* MovePicker::score(MoveList<Type>& ml) {
             m.value = (*captureHistory)[pc][to][type_of(capturedPiece)]
                     + 7 * int(PieceValue[capturedPiece]) + 1024 * bool(pos.check_squares(pt) & to);
 
-        else if constexpr (Type == QUIETS)
-        {
-            // histories
-            m.value = 2 * (*mainHistory)[us][m.from_to()];
-            m.value += 2 * (*pawnHistory)[pawn_history_index(pos)][pc][to];
-            m.value += (*continuationHistory[0])[pc][to];
-            m.value += (*continuationHistory[1])[pc][to];
-            m.value += (*continuationHistory[2])[pc][to];
-            m.value += (*continuationHistory[3])[pc][to];
-            m.value += (*continuationHistory[5])[pc][to];
-
-            // bonus for checks
-            m.value += (bool(pos.check_squares(pt) & to) && pos.see_ge(m, -75)) * 16384;
-
-            // penalty for moving to a square threatened by a lesser piece
-            // or bonus for escaping an attack by a lesser piece.
-            static constexpr int bonus[KING + 1] = {0, 0, 144, 144, 256, 517, 10000};
-            int v = threatByLesser[pt] & to ? -95 : 100 * bool(threatByLesser[pt] & from);
-            m.value += bonus[pt] * v;
-
-
-            if (ply < LOW_PLY_HISTORY_SIZE)
-                m.value += 8 * (*lowPlyHistory)[ply][m.from_to()] / (1 + ply);
-        }
-
         else  // Type == EVASIONS
         {
             if (pos.capture_stage(m))
@@ -644,6 +644,72 @@ class NumaConfig {
         return cfg;
     }
 
+    // Splits the NUMA nodes of from_system() into last level (L3) cache domains,
+    // read from /sys/devices/system/cpu/cpu*/cache on Linux. Domains on the same
+    // NUMA node share one replica of NUMA replicated objects, since the memory
+    // behind them is the same. SMT siblings are recorded so that threads can be
+    // kept on distinct physical cores. Without cache information this is
+    // from_system().
+    static NumaConfig from_cache_topology() {
+        NumaConfig numaCfg = from_system();
+
+#if defined(__linux__) && !defined(__ANDROID__)
+
+        NumaConfig                                             cfg = empty();
+        std::map<std::pair<NumaIndex, std::string>, NumaIndex> domains;
+
+        for (NumaIndex n = 0; n < numaCfg.nodes.size(); ++n)
+            for (CpuIndex c : numaCfg.nodes[n])
+            {
+                const std::string cpu = "/sys/devices/system/cpu/cpu" + std::to_string(c);
+
+                std::optional<std::string> l3;
+                for (int i = 0; !l3.has_value(); ++i)
+                {
+                    const std::string index = cpu + "/cache/index" + std::to_string(i);
+                    auto              level = read_file_to_string(index + "/level");
+                    if (!level.has_value())
+                        break;
+
+                    remove_whitespace(*level);
+                    if (*level == "3")
+                        l3 = read_file_to_string(index + "/shared_cpu_list");
+                }
+
+                if (!l3.has_value())
+                    return numaCfg;
+
+                remove_whitespace(*l3);
+                auto it = domains.try_emplace({n, *l3}, NumaIndex(domains.size())).first;
+                cfg.add_cpu_to_node(it->second, c);
+
+                if (cfg.replicaOf.size() <= it->second)
+                    cfg.replicaOf.resize(it->second + 1);
+                cfg.replicaOf[it->second] = n;
+
+                // Every CPU but the lowest numbered one of a core is an SMT sibling
+                auto siblings = read_file_to_string(cpu + "/topology/thread_siblings_list");
+                if (siblings.has_value())
+                {
+                    remove_whitespace(*siblings);
+                    auto cpus = indices_from_shortened_string(*siblings);
+                    if (!cpus.empty() && *std::min_element(cpus.begin(), cpus.end()) != c)
+                        cfg.smtSiblings.insert(c);
+                }
+            }
+
+        cfg.customAffinity = numaCfg.customAffinity;
+        cfg.cacheDomains   = true;
+
+        return cfg;
+
+#else
+
+        return numaCfg;
+
+#endif
+    }
+
     // ':'-separated numa nodes
     // ','-separated cpu indices
     // supports "first-last" range syntax for cpu indices
@@ -688,6 +754,31 @@ class NumaConfig {
 
     CpuIndex num_cpus() const { return nodeByCpu.size(); }
 
+    // Nodes are L3 cache domains, see from_cache_topology()
+    bool has_cache_domains() const { return cacheDomains; }
+
+    CpuIndex num_physical_cores_in_numa_node(NumaIndex n) const {
+        assert(n < nodes.size());
+        return CpuIndex(std::count_if(nodes[n].begin(), nodes[n].end(),
+                                      [this](CpuIndex c) { return !smtSiblings.count(c); }));
+    }
+
+    // NUMA replicated objects keep one instance per replica. Every node is its
+    // own replica unless several nodes share the same memory.
+    NumaIndex replica_of(NumaIndex n) const { return n < replicaOf.size() ? replicaOf[n] : n; }
+
+    NumaIndex num_replicas() const {
+        return replicaOf.empty() ? num_numa_nodes()
+                                 : *std::max_element(replicaOf.begin(), replicaOf.end()) + 1;
+    }
+
+    NumaIndex first_node_of_replica(NumaIndex r) const {
+        for (NumaIndex n = 0; n < nodes.size(); ++n)
+            if (replica_of(n) == r)
+                return n;
+        return NumaIndex{0};
+    }
+
     bool requires_memory_replication() const { return customAffinity || nodes.size() > 1; }
 
     std::string to_string() const {
@@ -792,8 +883,15 @@ class NumaConfig {
                 float     bestNodeFill = std::numeric_limits<float>::max();
                 for (NumaIndex n = 0; n < nodes.size(); ++n)
                 {
-                    float fill =
-                      static_cast<float>(occupation[n] + 1) / static_cast<float>(nodes[n].size());
+                    // Physical cores of every node are filled before SMT siblings.
+                    // Without SMT information this is occupation over node size.
+                    const size_t cores = num_physical_cores_in_numa_node(n);
+                    float        fill =
+                      occupation[n] < cores
+                               ? static_cast<float>(occupation[n] + 1) / static_cast<float>(cores)
+                               : 1.0f
+                            + static_cast<float>(occupation[n] + 1 - cores)
+                                / static_cast<float>(nodes[n].size());
                     // NOTE: Do we want to perhaps fill the first available node
                     //       up to 50% first before considering other nodes?
                     //       Probably not, because it would interfere with running
@@ -813,7 +911,10 @@ class NumaConfig {
         return ns;
     }
 
-    NumaReplicatedAccessToken bind_current_thread_to_numa_node(NumaIndex n) const {
+    // With physicalCoresOnly the SMT siblings of the node are left out of the
+    // affinity mask, so that the OS places the threads on distinct cores.
+    NumaReplicatedAccessToken bind_current_thread_to_numa_node(NumaIndex n,
+                                                               bool physicalCoresOnly = false) const {
         if (n >= nodes.size() || nodes[n].size() == 0)
             std::exit(EXIT_FAILURE);
 
@@ -828,7 +929,8 @@ class NumaConfig {
         CPU_ZERO_S(masksize, mask);
 
         for (CpuIndex c : nodes[n])
-            CPU_SET_S(c, masksize, mask);
+            if (!physicalCoresOnly || !smtSiblings.count(c))
+                CPU_SET_S(c, masksize, mask);
 
         const int status = sched_setaffinity(0, masksize, mask);
 
@@ -930,9 +1032,13 @@ class NumaConfig {
             SwitchToThread();
         }
 
+#else
+
+        (void) physicalCoresOnly;
+
 #endif
 
-        return NumaReplicatedAccessToken(n);
+        return NumaReplicatedAccessToken(replica_of(n));
     }
 
     template<typename FuncT>
@@ -950,6 +1056,11 @@ class NumaConfig {
     std::map<CpuIndex, NumaIndex>   nodeByCpu;
     CpuIndex                        highestCpuIndex;
 
+    // Set by from_cache_topology() only
+    std::vector<NumaIndex> replicaOf;
+    std::set<CpuIndex>     smtSiblings;
+    bool                   cacheDomains = false;
+
     bool customAffinity;
 
     static NumaConfig empty() { return NumaConfig(EmptyNodeTag{}); }
@@ -1136,10 +1247,11 @@ class NumaReplicated: public NumaReplicatedBase {
         const NumaConfig& cfg = get_numa_config();
         if (cfg.requires_memory_replication())
         {
-            for (NumaIndex n = 0; n < cfg.num_numa_nodes(); ++n)
+            for (NumaIndex r = 0; r < cfg.num_replicas(); ++r)
             {
-                cfg.execute_on_numa_node(
-                  n, [this, &source]() { instances.emplace_back(std::make_unique<T>(source)); });
+                cfg.execute_on_numa_node(cfg.first_node_of_replica(r), [this, &source]() {
+                    instances.emplace_back(std::make_unique<T>(source));
+                });
             }
         }
         else
@@ -1232,8 +1344,9 @@ class LazyNumaReplicated: public NumaReplicatedBase {
             return;
 
         const NumaConfig& cfg = get_numa_config();
-        cfg.execute_on_numa_node(
-          idx, [this, idx]() { instances[idx] = std::make_unique<T>(*instances[0]); });
+        cfg.execute_on_numa_node(cfg.first_node_of_replica(idx), [this, idx]() {
+            instances[idx] = std::make_unique<T>(*instances[0]);
+        });
     }
 
     void prepare_replicate_from(T&& source) {
@@ -1251,7 +1364,7 @@ class LazyNumaReplicated: public NumaReplicatedBase {
               0, [this, &source]() { instances.emplace_back(std::make_unique<T>(source)); });
 
             // Prepare others for lazy init.
-            instances.resize(cfg.num_numa_nodes());
+            instances.resize(cfg.num_replicas());
         }
         else
         {
@@ -0,0 +1,178 @@
+/*
+  HypnoS, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  HypnoS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  HypnoS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "perfcounters.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__linux__) && !defined(__ANDROID__)
+    #include <cerrno>
+    #include <cstring>
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+    #define PERFEVENTS
+#endif
+
+namespace Hypnos {
+
+namespace {
+
+constexpr const char* EventNames[PerfCounters::EVENT_NB] = {
+  "Cycles", "Instructions", "L1D misses", "LLC misses", "dTLB misses", "iTLB misses",
+  "Branch misses"};
+
+#if defined(PERFEVENTS)
+
+constexpr struct {
+    std::uint32_t type;
+    std::uint64_t config;
+} EventConfigs[PerfCounters::EVENT_NB] = {
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                         | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+  {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                         | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+  {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_ITLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                         | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+  {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}};
+
+#endif
+
+}  // namespace
+
+PerfCounters::Totals& PerfCounters::Totals::operator+=(const Totals& other) {
+    for (int e = 0; e < EVENT_NB; ++e)
+        count[e] += other.count[e];
+
+    // An event counts as available only if every thread could open it
+    opened = threads ? opened & other.opened : other.opened;
+    threads += other.threads;
+
+    if (error.empty())
+        error = other.error;
+
+    return *this;
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(PERFEVENTS)
+    for (int fd : fds)
+        if (fd >= 0)
+            close(fd);
+#endif
+}
+
+bool PerfCounters::open() {
+
+#if defined(PERFEVENTS)
+    bool any = false;
+
+    for (int e = 0; e < EVENT_NB; ++e)
+    {
+        perf_event_attr attr{};
+        attr.size           = sizeof(attr);
+        attr.type           = EventConfigs[e].type;
+        attr.config         = EventConfigs[e].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // pid 0 and cpu -1: the calling thread, on whatever CPU it runs
+        fds[e] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+
+        if (fds[e] < 0 && error.empty())
+            error = std::string("perf_event_open: ") + std::strerror(errno);
+
+        any |= fds[e] >= 0;
+    }
+
+    return any;
+#else
+    error = "not supported on this platform";
+    return false;
+#endif
+}
+
+PerfCounters::Totals PerfCounters::read() {
+
+    Totals t;
+    t.threads = 1;
+    t.error   = error;
+
+#if defined(PERFEVENTS)
+    for (int e = 0; e < EVENT_NB; ++e)
+    {
+        std::uint64_t v[3];  // value, time enabled, time running
+
+        if (fds[e] < 0 || ::read(fds[e], v, sizeof(v)) != sizeof(v))
+            continue;
+
+        ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+
+        // Scale up if the kernel had to multiplex the counter
+        t.count[e] = v[2] ? std::uint64_t(double(v[0]) * v[1] / v[2]) : 0;
+        t.opened |= 1u << e;
+    }
+#endif
+
+    return t;
+}
+
+std::string perf_counters_report(const PerfCounters::Totals& totals, std::uint64_t nodes) {
+
+    std::stringstream ss;
+    ss << "\nPerf counters   : ";
+
+    if (!totals.opened)
+    {
+        ss << "unavailable (" << (totals.error.empty() ? "no events" : totals.error) << ")";
+        return ss.str();
+    }
+
+    ss << totals.threads << (totals.threads == 1 ? " thread" : " threads") << ", user space";
+
+    auto has = [&](int e) { return bool(totals.opened & (1u << e)); };
+
+    for (int e = 0; e < PerfCounters::EVENT_NB; ++e)
+    {
+        ss << "\n" << std::left << std::setw(16) << EventNames[e] << ": ";
+
+        if (!has(e))
+        {
+            ss << "n/a";
+            continue;
+        }
+
+        ss << totals.count[e] << " (" << std::fixed << std::setprecision(3)
+           << double(totals.count[e]) / std::max<std::uint64_t>(nodes, 1) << " per node)";
+    }
+
+    if (has(PerfCounters::Cycles) && has(PerfCounters::Instructions) && totals.count[PerfCounters::Cycles])
+        ss << "\nIPC             : " << std::fixed << std::setprecision(2)
+           << double(totals.count[PerfCounters::Instructions]) / totals.count[PerfCounters::Cycles];
+
+    return ss.str();
+}
+
+}  // namespace Hypnos
@@ -0,0 +1,76 @@
+/*
+  HypnoS, a UCI chess playing engine derived from Stockfish
+  Copyright (C) 2004-2025 The Stockfish developers (see AUTHORS file)
+
+  HypnoS is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  HypnoS is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PERFCOUNTERS_H_INCLUDED
+#define PERFCOUNTERS_H_INCLUDED
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace Hypnos {
+
+// PerfCounters reads the hardware performance counters of the thread that
+// opened it, through Linux perf_event_open(). User space only, so that the
+// default perf_event_paranoid setting allows it. Events the CPU or the
+// hypervisor does not expose are left out, on other systems none opens.
+class PerfCounters {
+   public:
+    enum Event {
+        Cycles,
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        DTLBMisses,
+        ITLBMisses,
+        BranchMisses,
+        EVENT_NB
+    };
+
+    // Counts summed over threads, 'opened' has one bit per available event
+    struct Totals {
+        std::array<std::uint64_t, EVENT_NB> count{};
+        unsigned                            opened  = 0;
+        std::size_t                         threads = 0;
+        std::string                         error;
+
+        Totals& operator+=(const Totals& other);
+    };
+
+    PerfCounters() = default;
+    PerfCounters(const PerfCounters&)            = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters();
+
+    // Opens and starts the counters for the calling thread
+    bool open();
+
+    // Stops the counters and returns their values, scaled for multiplexing
+    Totals read();
+
+   private:
+    std::array<int, EVENT_NB> fds{-1, -1, -1, -1, -1, -1, -1};
+    std::string               error;
+};
+
+// Formats IPC and the per node rates of the counters for bench reports
+std::string perf_counters_report(const PerfCounters::Totals& totals, std::uint64_t nodes);
+
+}  // namespace Hypnos
+
+#endif  // #ifndef PERFCOUNTERS_H_INCLUDED
@@ -19,8 +19,10 @@
 #ifndef PERFT_H_INCLUDED
 #define PERFT_H_INCLUDED
 
+#include <algorithm>
 #include <cstdint>
 
+#include "benchmark.h"
 #include "movegen.h"
 #include "position.h"
 #include "types.h"
@@ -62,6 +64,56 @@ inline uint64_t perft(const std::string& fen, Depth depth, bool isChess960) {
 
     return perft<true>(p, depth);
 }
+
+// Same walk as perft(), but leaf moves are classified instead of bulk counted.
+// Only checking moves are made, to tell checkmates apart.
+template<bool Root>
+void perft_stats(Position& pos, Depth depth, PerftStats& stats) {
+
+    StateInfo st;
+
+    for (const auto& m : MoveList<LEGAL>(pos))
+    {
+        uint64_t nodes = stats.nodes;
+
+        if (depth > 1)
+        {
+            pos.do_move(m, st);
+            perft_stats<false>(pos, depth - 1, stats);
+            pos.undo_move(m);
+        }
+        else
+        {
+            stats.nodes++;
+            stats.captures += pos.capture(m);
+            stats.enPassants += m.type_of() == EN_PASSANT;
+            stats.castles += m.type_of() == CASTLING;
+            stats.promotions += m.type_of() == PROMOTION;
+
+            if (pos.gives_check(m))
+            {
+                stats.checks++;
+                pos.do_move(m, st);
+                stats.mates += !MoveList<LEGAL>(pos).size();
+                pos.undo_move(m);
+            }
+        }
+
+        if (Root)
+            sync_cout << UCIEngine::move(m, pos.is_chess960()) << ": " << stats.nodes - nodes
+                      << sync_endl;
+    }
+}
+
+inline PerftStats perft_stats(const std::string& fen, Depth depth, bool isChess960) {
+    StateInfo  st;
+    Position   p;
+    PerftStats stats{};
+    p.set(fen, isChess960, &st);
+
+    perft_stats<true>(p, std::max(depth, 1), stats);
+    return stats;
+}
 }
 
 #endif  // PERFT_H_INCLUDED
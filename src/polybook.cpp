@@ -23,26 +23,21 @@
 #include <iostream>
 #include "misc.h"
 #include <sys/timeb.h>
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 
 using namespace std;
 
 namespace Hypnos {
 
-PolyBook polybook[2];
-PRNG     rng(time(NULL));
+PolyBook  polybook[2];
+BookIndex bookIndex;
+PRNG      rng(time(NULL));
 
-namespace {
-// Random numbers from PolyGlot, used to compute book hash keys
-const union {
-    uint64_t PolyGlotRandoms[781];
-    struct {
-        uint64_t psq[12][64];   // [piece][square]
-        uint64_t castle[4];     // [castle right]
-        uint64_t enpassant[8];  // [file]
-        uint64_t turn;
-    } Zobrist;
-} PG = {{0x9D39247E33776D41ULL, 0x2AF7398005AAA5C7ULL, 0x44DB015024623547ULL, 0x9C15F73E62A76AE2ULL,
+std::atomic<bool> Polyglot::trackKeys{false};
+
+const PolyglotRandoms Polyglot::PG = {{0x9D39247E33776D41ULL, 0x2AF7398005AAA5C7ULL, 0x44DB015024623547ULL, 0x9C15F73E62A76AE2ULL,
          0x75834465489C0C89ULL, 0x3290AC3A203001BFULL, 0x0FBBAD1F61042279ULL, 0xE83A908FF2FB60CAULL,
          0x0D7E765D58755C10ULL, 0x1A083822CEAFE02DULL, 0x9605D5F0E25EC3B0ULL, 0xD021FF5CD13A2ED5ULL,
          0x40BDF15D4A672E32ULL, 0x011355146FD56395ULL, 0x5DB4832046F3D9E5ULL, 0x239F8B2D7FF719CCULL,
@@ -238,7 +233,6 @@ const union {
          0x70CC73D90BC26E24ULL, 0xE21A6B35DF0C3AD7ULL, 0x003A93D8B2806962ULL, 0x1C99DED33CB890A1ULL,
          0xCF3145DE0ADD4289ULL, 0xD0E4427A5514FB72ULL, 0x77C621CC9FB3A483ULL, 0x67A34DAC4356550BULL,
          0xF8D626AAAF278509ULL}};
-}
 
 namespace {
 bool is_little_endian() {
@@ -302,9 +296,6 @@ PolyBook::PolyBook() {
     keycount = 0;
     polyhash = NULL;
     enabled  = false;
-
-    index_first = index_best = index_rand = 0;
-    index_count = index_weight_count = 0;
 }
 
 PolyBook::~PolyBook() {
@@ -317,8 +308,18 @@ void PolyBook::init(const OptionsMap& options) {
     polybook[1].init(options["Book2 File"]);
 }
 
+void PolyBook::refresh_key_tracking() {
+    Polyglot::trackKeys = polybook[0].enabled || polybook[1].enabled;
+}
+
 void PolyBook::init(const std::string& bookfile) {
-    enabled = false;
+    // keycount is only set again once the whole book has been read, so the
+    // failure paths below leave a disabled book without entries.
+    enabled  = false;
+    keycount = 0;
+    refresh_key_tracking();
+    bookIndex.rebuild();
+
     if (bookfile.empty())
         return;
 
@@ -339,7 +340,6 @@ void PolyBook::init(const std::string& bookfile) {
     size_t filesize = (size_t) ftell(fpt);
     fseek(fpt, 0L, SEEK_SET);
 
-    keycount = filesize / 16;
     polyhash = (PolyHash*) malloc(filesize);
     if (!polyhash)
     {
@@ -359,102 +359,166 @@ void PolyBook::init(const std::string& bookfile) {
         return;
     }
 
+    keycount = int(filesize / 16);
+
     for (int i = 0; i < keycount; i++)
         byteswap_polyhash(&polyhash[i]);
 
     sync_cout << "info string Book loaded: " << bookfile << sync_endl;
 
     enabled = true;
+    refresh_key_tracking();
+    bookIndex.rebuild();
 }
 
-Move PolyBook::probe(Position& pos, bool bestBookMove, int width) {
-    if (!enabled)
-        return Move::none();
+void BookIndex::rebuild() {
+    std::lock_guard<std::mutex> lock(mutex);
 
-    Key key = polyglot_key(pos);
-    int n   = find_first_key(key);
-    if (n < 1)
-        return Move::none();
+    entries.clear();
+    for (auto& book : weights)
+        for (auto& table : book)
+            table.clear();
+
+    // Walk both sorted books in parallel, one entry per distinct key
+    int i[2] = {0, 0};
 
-    Move m;
+    auto at_end = [&](int b) { return !polybook[b].enabled || i[b] >= polybook[b].keycount; };
 
-    if (bestBookMove || n == 1)
+    while (!at_end(0) || !at_end(1))
     {
-        int idx = index_best;
-        m = pg_move_to_sf_move(pos, polyhash[idx].move);
+        Key key = std::min(at_end(0) ? ~Key(0) : polybook[0].polyhash[i[0]].key,
+                           at_end(1) ? ~Key(0) : polybook[1].polyhash[i[1]].key);
+
+        Entry e{key, {{0, 0, 0}, {0, 0, 0}}};
+
+        for (int b = 0; b < 2; ++b)
+        {
+            const PolyHash* ph = polybook[b].polyhash;
+            Range&          r  = e.range[b];
+
+            r.first = r.best = i[b];
+            while (!at_end(b) && ph[i[b]].key == key)
+            {
+                if (ph[i[b]].weight > ph[r.best].weight)
+                    r.best = i[b];
+                ++r.count, ++i[b];
+            }
+        }
+
+        entries.push_back(e);
     }
-    else
+
+    for (int b = 0; b < 2; ++b)
+        cumulative(b, widths[b]);
+}
+
+void BookIndex::set_width(int book, int width) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    widths[book] = std::clamp(width, 1, 10);
+    cumulative(book, widths[book]);
+}
+
+// Cumulative weights of every book entry raised to the Book Width exponent.
+// Sums restart at the first move of each position. Tables for the configured
+// widths exist already, others (a session probing with its own Book Width)
+// are built here on first use. Caller holds the mutex.
+const std::vector<double>& BookIndex::cumulative(int book, int width) {
+    std::vector<double>& table = weights[book][width - 1];
+
+    if (table.empty() && polybook[book].enabled && polybook[book].polyhash)
     {
         // Smooth mapping: from width=1 (free/random) to width=10 (selective/strict)
-        double exponent = 1.0 + (std::clamp(width, 1, 10) - 1) * 0.5;
+        double exponent = 1.0 + (width - 1) * 0.5;
 
-        std::vector<double> scores(n);
-        double total = 0.0;
+        const PolyHash* ph = polybook[book].polyhash;
+        table.resize(polybook[book].keycount);
 
-        for (int i = 0; i < n; ++i)
+        double sum = 0.0;
+        for (int i = 0; i < polybook[book].keycount; ++i)
         {
-            int w = polyhash[index_first + i].weight;
-            double s = std::pow(static_cast<double>(w), exponent);
-            scores[i] = s;
-            total += s;
+            if (i == 0 || ph[i].key != ph[i - 1].key)
+                sum = 0.0;
+
+            sum += std::pow(static_cast<double>(ph[i].weight), exponent);
+            table[i] = sum;
         }
+    }
 
-        double r = (double)(rng.rand<uint32_t>() % 1000000) / 1000000.0 * total;
-        double sum = 0.0;
-        int idx = index_first;
+    return table;
+}
 
-        for (int i = 0; i < n; ++i)
-        {
-            sum += scores[i];
-            if (sum >= r)
-            {
-                idx = index_first + i;
-                break;
-            }
-        }
+Move BookIndex::pick(int book, Position& pos, const Range& r, const BookChoice& c) {
+    PolyBook&       pb = polybook[book];
+    const PolyHash* ph = pb.polyhash;
+    int             n  = r.count;
+    Move            m;
 
-        m = pg_move_to_sf_move(pos, polyhash[idx].move);
+    if (c.bestMove || n == 1)
+        m = pb.pg_move_to_sf_move(pos, ph[r.best].move);
+    else
+    {
+        const double* cum   = cumulative(book, std::clamp(c.width, 1, 10)).data() + r.first;
+        double        total = cum[n - 1];
+        double        x     = (double) (rng.rand<uint32_t>() % 1000000) / 1000000.0 * total;
+
+        // First move whose cumulative weight reaches x
+        int i = int(std::lower_bound(cum, cum + n, x) - cum);
+        int idx = r.first + (i < n ? i : 0);
+
+        m = pb.pg_move_to_sf_move(pos, ph[idx].move);
     }
 
-    if (n == 1 || !check_draw(pos, m))
+    if (n == 1 || !pb.check_draw(pos, m))
         return m;
 
-    if (n > 1)
-    {
-        int idx = index_first;
-        if (m == pg_move_to_sf_move(pos, polyhash[index_first].move))
-            idx = index_first + 1;
+    int idx = r.first;
+    if (m == pb.pg_move_to_sf_move(pos, ph[r.first].move))
+        idx = r.first + 1;
 
-        m = pg_move_to_sf_move(pos, polyhash[idx].move);
-        if (!check_draw(pos, m))
-            return m;
-    }
+    m = pb.pg_move_to_sf_move(pos, ph[idx].move);
+    if (!pb.check_draw(pos, m))
+        return m;
 
     return Move::none();
 }
 
+Move BookIndex::probe(Position& pos, const BookChoice (&choice)[2]) {
+    if (!(choice[0].use && polybook[0].enabled) && !(choice[1].use && polybook[1].enabled))
+        return Move::none();
+
+    std::lock_guard<std::mutex> lock(mutex);
 
-Key PolyBook::polyglot_key(const Position& pos) {
+    Key  key = polybook[0].polyglot_key(pos);
+    auto it  = std::lower_bound(entries.begin(), entries.end(), key,
+                                [](const Entry& e, Key k) { return e.key < k; });
+
+    if (it == entries.end() || it->key != key)
+        return Move::none();
+
+    for (int b = 0; b < 2; ++b)
+        if (choice[b].use && polybook[b].enabled && it->range[b].count)
+        {
+            Move m = pick(b, pos, it->range[b], choice[b]);
+            if (m != Move::none())
+                return m;
+        }
+
+    return Move::none();
+}
+
+
+Key Polyglot::compute_key(const Position& pos) {
     Key      key = 0;
     Bitboard b   = pos.pieces();
 
     while (b)
     {
         Square s = pop_lsb(b);
-        Piece  p = pos.piece_on(s);
-
-        // PolyGlot pieces are: BP = 0, WP = 1, BN = 2, ... BK = 10, WK = 11
-        key ^= PG.Zobrist.psq[2 * (type_of(p) - 1) + (color_of(p) == WHITE)][s];
+        key ^= psq(pos.piece_on(s), s);
     }
 
-    if (pos.can_castle(WHITE_OO))
-        key ^= PG.Zobrist.castle[0];
-    if (pos.can_castle(WHITE_OOO))
-        key ^= PG.Zobrist.castle[1];
-    if (pos.can_castle(BLACK_OO))
-        key ^= PG.Zobrist.castle[2];
-    if (pos.can_castle(BLACK_OOO))
-        key ^= PG.Zobrist.castle[3];
+    key ^= castling(pos.state()->castlingRights);
 
     if (pos.ep_square() != SQ_NONE)
         key ^= PG.Zobrist.enpassant[file_of(pos.ep_square())];
@@ -465,6 +529,15 @@ Key PolyBook::polyglot_key(const Position& pos) {
     return key;
 }
 
+// Uses the incrementally maintained key when available
+Key PolyBook::polyglot_key(const Position& pos) {
+    Key key = pos.polyglot_key();
+
+    assert(!key || key == Polyglot::compute_key(pos));
+
+    return key ? key : Polyglot::compute_key(pos);
+}
+
 // A PolyGlot book move is encoded as follows:
 //
 // bit  0- 5: destination square (from 0 to 63)
@@ -491,97 +564,13 @@ Move PolyBook::pg_move_to_sf_move(const Position& pos, unsigned short pg_move) {
     // Add 'special move' flags and verify it is legal
     for (const auto& m : MoveList<LEGAL>(pos))
     {
-        if (move.raw()
+        if ((move.raw() & (~(3 << 14)))
             == (m.raw() & (~(3 << 14))))  //  compare with MoveType (bit 14-15)  masked out
             return m;
     }
 
     return Move::none();
 }
-int PolyBook::find_first_key(uint64_t key) {
-    index_first        = -1;
-    index_count        = 0;
-    index_weight_count = 0;
-    index_best         = -1;
-    index_rand         = -1;
-
-    int start = 0;
-    int end   = keycount;
-
-    for (;;)
-    {
-        int mid = (end + start) / 2;
-
-        if (polyhash[mid].key < key)
-            start = mid;
-        else
-        {
-            if (polyhash[mid].key > key)
-                end = mid;
-            else
-            {
-                start = max(mid - 4, 0);
-                end   = min(mid + 4, keycount);
-            }
-        }
-
-        if (end - start < 9)
-            break;
-    }
-
-    for (int i = start; i < end; i++)
-    {
-        if (key == polyhash[i].key)
-        {
-            index_first = i;
-            while ((index_first > 0) && (key == polyhash[index_first - 1].key))
-                index_first--;
-            return get_key_data();
-        }
-    }
-
-    return -1;
-}
-
-int PolyBook::get_key_data() {
-    int best_weight    = polyhash[index_first].weight;
-    index_weight_count = best_weight;
-    uint64_t key       = polyhash[index_first].key;
-
-    index_count = 1;
-    index_best  = index_first;
-
-    for (int i = index_first + 1; i < keycount; i++)
-    {
-        if (polyhash[i].key != key)
-            break;
-
-        index_count++;
-        index_weight_count += polyhash[i].weight;
-        if (polyhash[i].weight > best_weight)
-        {
-            best_weight = polyhash[i].weight;
-            index_best  = i;
-        }
-    }
-
-    int rand_pos     = (rng.rand<uint32_t>() % index_weight_count);
-    int weight_count = 0;
-    index_rand       = index_best;
-
-    for (int i = index_first; i < index_first + index_count; i++)
-    {
-        if ((rand_pos >= weight_count) && (rand_pos < weight_count + polyhash[i].weight))
-        {
-            index_rand = i;
-            break;
-        }
-        weight_count += polyhash[i].weight;
-    }
-
-    return index_count;
-}
-
 bool PolyBook::check_draw(Position& pos, Move m) {
     StateInfo st;
 
@@ -19,6 +19,10 @@
 #ifndef POLYBOOK_H_INCLUDED
 #define POLYBOOK_H_INCLUDED
 
+#include <atomic>
+#include <mutex>
+#include <vector>
+
 #include "bitboard.h"
 #include "position.h"
 #include "string.h"
@@ -26,6 +30,42 @@
 
 namespace Hypnos {
 
+// Random numbers from PolyGlot, used to compute book hash keys
+union PolyglotRandoms {
+    uint64_t PolyGlotRandoms[781];
+    struct {
+        uint64_t psq[12][64];   // [piece][square]
+        uint64_t castle[4];     // [castle right]
+        uint64_t enpassant[8];  // [file]
+        uint64_t turn;
+    } Zobrist;
+};
+
+namespace Polyglot {
+
+extern const PolyglotRandoms PG;
+
+// Set while a book is loaded. Position then keeps StateInfo::polyKey up to
+// date in do_move(), otherwise the key is zero and computed on demand.
+extern std::atomic<bool> trackKeys;
+
+// PolyGlot pieces are: BP = 0, WP = 1, BN = 2, ... BK = 10, WK = 11
+inline Key psq(Piece pc, Square s) {
+    return PG.Zobrist.psq[2 * (type_of(pc) - 1) + (color_of(pc) == WHITE)][s];
+}
+
+inline Key castling(int castlingRights) {
+    Key key = 0;
+    for (int i = 0; i < 4; ++i)
+        if (castlingRights & (1 << i))
+            key ^= PG.Zobrist.castle[i];
+    return key;
+}
+
+Key compute_key(const Position& pos);
+
+}  // namespace Polyglot
+
 typedef struct {
     uint64_t key;
     uint16_t move;
@@ -40,30 +80,70 @@ class PolyBook {
 
     static void     init(const OptionsMap&);
     void            init(const std::string& bookfile);
-    Hypnos::Move probe(Hypnos::Position& pos, bool bestBookMove, int width = 10);
 
    private:
+    friend class BookIndex;
+
+    static void refresh_key_tracking();
+
     Hypnos::Key  polyglot_key(const Hypnos::Position& pos);
     Hypnos::Move pg_move_to_sf_move(const Hypnos::Position& pos, unsigned short pg_move);
 
-    int find_first_key(uint64_t key);
-    int get_key_data();
-
     bool check_draw(Hypnos::Position& pos, Hypnos::Move m);
 
     int       keycount;
     PolyHash* polyhash;
     bool      enabled;
-
-    int index_first;
-    int index_best;
-    int index_rand;
-    int index_count;
-    int index_weight_count;
 };
 
 extern PolyBook polybook[2];
 
+// Settings of one book for a single root probe
+struct BookChoice {
+    bool use;
+    bool bestMove;
+    int  width;
+};
+
+// Merged view over both books, rebuilt whenever a book is (re)loaded. Each
+// position key is stored once with its entry range in either book, so a
+// probe is a single binary search. Weighted picks use per-position
+// cumulative weight tables, built at load time for the configured Book Width
+// and again when it changes, so root probes never build them.
+class BookIndex {
+   public:
+    void rebuild();
+
+    // Sets the Book Width of a book and builds its weight table
+    void set_width(int book, int width);
+
+    // Tries book 1 then book 2, as configured by choice[]
+    Hypnos::Move probe(Hypnos::Position& pos, const BookChoice (&choice)[2]);
+
+   private:
+    struct Range {
+        int first, count, best;
+    };
+
+    struct Entry {
+        Hypnos::Key key;
+        Range       range[2];
+    };
+
+    const std::vector<double>& cumulative(int book, int width);
+    Hypnos::Move pick(int book, Hypnos::Position& pos, const Range& r, const BookChoice& c);
+
+    std::vector<Entry>  entries;
+    std::vector<double> weights[2][10];  // [book][width - 1], restarts at every key
+    int                 widths[2] = {1, 1};
+
+    // Guards the lazily built tables and the shared PRNG, concurrent root
+    // searches (analyze groups) take turns probing.
+    std::mutex mutex;
+};
+
+extern BookIndex bookIndex;
+
 }
 
 #endif  // #ifndef POLYBOOK_H_INCLUDED
@@ -34,6 +34,7 @@
 #include "bitboard.h"
 #include "misc.h"
 #include "movegen.h"
+#include "polybook.h"
 #include "syzygy/tbprobe.h"
 #include "tt.h"
 #include "uci.h"
@@ -390,6 +391,9 @@ void Position::set_state() const {
     for (Piece pc : Pieces)
         for (int cnt = 0; cnt < pieceCount[pc]; ++cnt)
             st->materialKey ^= Zobrist::psq[pc][8 + cnt];
+
+    st->polyKey =
+      Polyglot::trackKeys.load(std::memory_order_relaxed) ? Polyglot::compute_key(*this) : 0;
 }
 
 
@@ -462,6 +466,76 @@ string Position::fen() const {
     return ss.str();
 }
 
+// Returns the 32-byte binary encoding of the position, see PackedPosition.
+// A legal position never has more than 32 pieces, so the nibbles always fit.
+PackedPosition Position::pack() const {
+
+    PackedPosition pp{};
+    Bitboard       occupied = pieces();
+
+    assert(popcount(occupied) <= 32);
+
+    for (int i = 0; i < 8; ++i)
+        pp.data[i] = uint8_t(occupied >> (8 * i));
+
+    for (int n = 0; occupied; ++n)
+        pp.data[8 + n / 2] |= uint8_t(piece_on(pop_lsb(occupied)) << (4 * (n & 1)));
+
+    int rookFiles = 0;
+    for (int i = 0; i < 4; ++i)
+        if (can_castle(CastlingRights(1 << i)))
+            rookFiles |= file_of(castling_rook_square(CastlingRights(1 << i))) << (3 * i);
+
+    pp.data[24] = uint8_t((sideToMove == BLACK) | (chess960 << 1) | (st->castlingRights << 4));
+    pp.data[25] = uint8_t(st->epSquare);
+    pp.data[26] = uint8_t(std::min(st->rule50, 255));
+    pp.data[27] = uint8_t(gamePly);
+    pp.data[28] = uint8_t(gamePly >> 8);
+    pp.data[29] = uint8_t(rookFiles);
+    pp.data[30] = uint8_t(rookFiles >> 8);
+
+    return pp;
+}
+
+
+// Initializes the position object from its binary encoding. Like the FEN
+// variant, the input is trusted: it is expected to come from pack().
+Position& Position::set(const PackedPosition& pp, StateInfo* si) {
+
+    std::memset(this, 0, sizeof(Position));
+    std::memset(si, 0, sizeof(StateInfo));
+    st = si;
+
+    Bitboard occupied = 0;
+    for (int i = 0; i < 8; ++i)
+        occupied |= Bitboard(pp.data[i]) << (8 * i);
+
+    for (int n = 0; occupied; ++n)
+        put_piece(Piece((pp.data[8 + n / 2] >> (4 * (n & 1))) & 0xF), pop_lsb(occupied));
+
+    sideToMove = (pp.data[24] & 1) ? BLACK : WHITE;
+    chess960   = pp.data[24] & 2;
+
+    int rookFiles = pp.data[29] | (pp.data[30] << 8);
+    for (int i = 0; i < 4; ++i)
+        if (pp.data[24] & (1 << (4 + i)))
+        {
+            Color c = i < 2 ? WHITE : BLACK;
+            set_castling_right(c, make_square(File((rookFiles >> (3 * i)) & 7),
+                                              relative_rank(c, RANK_1)));
+        }
+
+    st->epSquare = pp.data[25] < SQUARE_NB ? Square(pp.data[25]) : SQ_NONE;
+    st->rule50   = pp.data[26];
+    gamePly      = pp.data[27] | (pp.data[28] << 8);
+
+    set_state();
+
+    assert(pos_is_ok());
+
+    return *this;
+}
+
 // Calculates st->blockersForKing[c] and st->pinners[~c],
 // which store respectively the pieces preventing king of color c from being in check
 // and the slider pieces of color ~c pinning pieces of color c to the king.
@@ -938,6 +1012,32 @@ DirtyPiece Position::do_move(Move                      m,
     if (tt)
         prefetch(tt->first_entry(key()));
 
+    // Update the Polyglot key, only tracked while a book is loaded
+    if (st->polyKey)
+    {
+        Key pk = Polyglot::PG.Zobrist.turn ^ Polyglot::psq(pc, from)
+               ^ Polyglot::psq(piece_on(to), to) ^ Polyglot::castling(st->previous->castlingRights)
+               ^ Polyglot::castling(st->castlingRights);
+
+        if (m.type_of() == CASTLING)
+        {
+            Square rfrom = m.to_sq();
+            Square rto   = relative_square(us, rfrom > from ? SQ_F1 : SQ_D1);
+            Piece  rook  = make_piece(us, ROOK);
+            pk ^= Polyglot::psq(rook, rfrom) ^ Polyglot::psq(rook, rto);
+        }
+        else if (captured)
+            pk ^= Polyglot::psq(captured, m.type_of() == EN_PASSANT ? to - pawn_push(us) : to);
+
+        if (st->previous->epSquare != SQ_NONE)
+            pk ^= Polyglot::PG.Zobrist.enpassant[file_of(st->previous->epSquare)];
+
+        if (st->epSquare != SQ_NONE)
+            pk ^= Polyglot::PG.Zobrist.enpassant[file_of(st->epSquare)];
+
+        st->polyKey ^= pk;
+    }
+
     // Calculate the repetition info. It is the ply distance from the previous
     // occurrence of the same position, negative in the 3-fold case, or zero
     // if the position was not repeated.
@@ -1076,12 +1176,19 @@ void Position::do_null_move(StateInfo& newSt, const TranspositionTable& tt) {
     if (st->epSquare != SQ_NONE)
     {
         st->key ^= Zobrist::enpassant[file_of(st->epSquare)];
+
+        if (st->polyKey)
+            st->polyKey ^= Polyglot::PG.Zobrist.enpassant[file_of(st->epSquare)];
+
         st->epSquare = SQ_NONE;
     }
 
     st->key ^= Zobrist::side;
     prefetch(tt.first_entry(key()));
 
+    if (st->polyKey)
+        st->polyKey ^= Polyglot::PG.Zobrist.turn;
+
     st->pliesFromNull = 0;
 
     sideToMove = ~sideToMove;
@@ -48,6 +48,7 @@ struct StateInfo {
     int    rule50;
     int    pliesFromNull;
     Square epSquare;
+    Key    polyKey;  // Polyglot book key, zero unless a book is loaded
 
     // Not copied when making a move (will be recomputed anyhow)
     Key        key;
@@ -68,6 +69,22 @@ struct StateInfo {
 using StateListPtr = std::unique_ptr<std::deque<StateInfo>>;
 
 
+// PackedPosition is a fixed-size binary encoding of a position, used for bulk
+// position files where FEN parsing would dominate. Layout:
+//   bytes  0-7   occupancy bitboard, little-endian
+//   bytes  8-23  one piece code per occupied square in square order, 4 bits each
+//   byte   24    bit 0 side to move, bit 1 Chess960, bits 4-7 castling rights
+//   byte   25    en passant square (SQUARE_NB if none)
+//   byte   26    rule50 counter
+//   bytes 27-28  game ply, little-endian
+//   bytes 29-30  castling rook files, 3 bits per castling right
+struct PackedPosition {
+    uint8_t data[32];
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must be 32 bytes");
+
+
 // Position class stores information regarding the board representation as
 // pieces, side to move, hash keys, castling info, etc. Important methods are
 // do_move() and undo_move(), used by the search to update node info when
@@ -85,6 +102,10 @@ class Position {
     Position&   set(const std::string& code, Color c, StateInfo* si);
     std::string fen() const;
 
+    // Binary input/output, see PackedPosition
+    Position&      set(const PackedPosition& pp, StateInfo* si);
+    PackedPosition pack() const;
+
     // Position representation
     Bitboard pieces() const;  // All pieces
     template<typename... PieceTypes>
@@ -146,6 +167,7 @@ class Position {
     Key pawn_key() const;
     Key minor_piece_key() const;
     Key non_pawn_key(Color c) const;
+    Key polyglot_key() const;
 
     // Other properties of the position
     Color side_to_move() const;
@@ -290,6 +312,8 @@ inline Key Position::adjust_key50(Key k) const {
 
 inline Key Position::pawn_key() const { return st->pawnKey; }
 
+inline Key Position::polyglot_key() const { return st->polyKey; }
+
 inline Key Position::material_key() const { return st->materialKey; }
 
 inline Key Position::minor_piece_key() const { return st->minorPieceKey; }
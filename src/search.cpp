@@ -31,6 +31,7 @@
 #include <iostream>
 #include <list>
 #include <ratio>
+#include <sstream>
 #include <string>
 #include <utility>
 
@@ -64,11 +65,13 @@ thread_local float g_dyn_prev = 0.0f;
 
 namespace TB = Tablebases;
 
-void syzygy_extend_pv(const OptionsMap&            options,
+void syzygy_extend_pv(const Search::SearchConfig&  searchConfig,
                       const Search::LimitsType&    limits,
+                      TimePoint                    moveOverhead,
                       Hypnos::Position&         pos,
                       Hypnos::Search::RootMove& rootMove,
-                      Value&                       v);
+                      Value&                       v,
+                      Hypnos::Search::SyzygyPVCache& cache);
 
 using namespace Search;
 
@@ -168,6 +171,54 @@ Search::Worker::Worker(SharedState&                    sharedState,
     clear();
 }
 
+Search::SearchConfig::SearchConfig(const OptionsMap& options) {
+    multiPV       = size_t(options["MultiPV"]);
+    skillLevel    = int(options["Skill Level"]);
+    uciElo        = int(options["UCI_Elo"]);
+    limitStrength = bool(options["UCI_LimitStrength"]);
+    ponder        = bool(options["Ponder"]);
+    treeReuse     = bool(options["Tree Reuse"]);
+    logWeights    = bool(options["NNUE Log Weights"]);
+
+    moveOverhead         = int(options["Move Overhead"]);
+    adaptiveMoveOverhead = bool(options["Adaptive Move Overhead"]);
+    minimumThinkingTime  = int(options["Minimum Thinking Time"]);
+    slowMover            = int(options["Slow Mover"]);
+    nodestime            = int(options["nodestime"]);
+    nodesPerThread       = bool(options["Nodes Per Thread"]);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        const std::string prefix = "Book" + std::to_string(i + 1);
+
+        book[i]         = bool(options[prefix]);
+        bookBestMove[i] = bool(options[prefix + " BestBookMove"]);
+        bookDepth[i]    = int(options[prefix + " Depth"]);
+        bookWidth[i]    = int(options[prefix + " Width"]);
+    }
+
+    experienceReadonly           = bool(options["Experience Readonly"]);
+    experienceBook               = bool(options["Experience Book"]);
+    experienceBookWidth          = int(options["Experience Book Width"]);
+    experienceBookEvalImportance = int(options["Experience Book Eval Importance"]);
+    experienceBookMinDepth       = int(options["Experience Book Min Depth"]);
+    experienceBookMaxMoves       = int(options["Experience Book Max Moves"]);
+    experienceGuidedSearch       = bool(options["Experience Guided Search"]);
+
+    variety         = int(options["Variety"]);
+    varietyMaxScore = int(options["Variety Max Score"]);
+    varietyMaxMoves = int(options["Variety Max Moves"]);
+
+    failInfoEnabled  = bool(options["FailInfo Enabled"]);
+    failInfoFirstMs  = int(options["FailInfo First ms"]);
+    failInfoMinNodes = uint64_t(int(options["FailInfo Min Nodes"]));
+    failInfoRateMs   = int(options["FailInfo Rate ms"]);
+
+    syzygy.useRule50   = bool(options["Syzygy50MoveRule"]);
+    syzygy.probeDepth  = int(options["SyzygyProbeDepth"]);
+    syzygy.cardinality = int(options["SyzygyProbeLimit"]);
+}
+
 void Search::Worker::ensure_network_replicated() {
     // Access once to force lazy initialization.
     // We do this because we want to avoid initialization during search.
@@ -182,24 +233,22 @@ void Search::Worker::start_searching() {
     if (!is_mainthread())
     {
         iterative_deepening();
+        publish_nodes();
         return;
     }
 
-    main_manager()->tm.init(limits, rootPos.side_to_move(), rootPos.game_ply(), options,
+    main_manager()->tm.init(limits, rootPos.side_to_move(), rootPos.game_ply(), config,
                             main_manager()->originalTimeAdjust);
-    tt.new_search();
+    main_manager()->varietyPicked = false;
+    if (main_manager()->ageTT)
+        tt.new_search();
 #if defined(HYP_FIXED_ZOBRIST)
     // Make sure experience has finished loading
     Experience::wait_for_loading_finished();
 #endif
 
-    // Initialize Variety config once per search (cached in this worker)
-    varietyCfg.enabled  = int(options["Variety"]);
-    varietyCfg.maxScore = int(options["Variety Max Score"]);
-    varietyCfg.maxMoves = int(options["Variety Max Moves"]);
-
     // Root-only NNUE weights log (prints once per search when enabled)
-    if (is_mainthread() && bool(options["NNUE Log Weights"])) {
+    if (is_mainthread() && config.logWeights) {
         using Hypnos::Eval::WeightsMode;
 
         // 1) Decide small/big net like evaluate()
@@ -294,6 +343,7 @@ void Search::Worker::start_searching() {
     }
 
     Move bookMove = Move::none();
+    bool searched = false;
 
     if (rootMoves.empty())
     {
@@ -305,33 +355,28 @@ void Search::Worker::start_searching() {
     {
         if (!limits.infinite && !limits.mate)
         {
-            // Polyglot Book 1
-            if ((bool) options["Book1"] && rootPos.game_ply() / 2 < (int) options["Book1 Depth"])
-                bookMove = polybook[0].probe(rootPos,
-                                             (bool) options["Book1 BestBookMove"],
-                                             (int) options["Book1 Width"]);
-
-            // Polyglot Book 2
-            if (bookMove == Move::none() && (bool) options["Book2"]
-                && rootPos.game_ply() / 2 < (int) options["Book2 Depth"])
-                bookMove = polybook[1].probe(rootPos,
-                                             (bool) options["Book2 BestBookMove"],
-                                             (int) options["Book2 Width"]);
+            // Polyglot books, book 1 first then book 2
+            BookChoice choice[2];
+            for (int i = 0; i < 2; ++i)
+                choice[i] = {config.book[i] && rootPos.game_ply() / 2 < config.bookDepth[i],
+                             config.bookBestMove[i], config.bookWidth[i]};
+
+            bookMove = bookIndex.probe(rootPos, choice);
 
 #if defined(HYP_FIXED_ZOBRIST)
             // Experience Book (only if no move from the book.bin)
             if (bookMove == Move::none()
-                && (bool) options["Experience Book"]
-                && rootPos.game_ply() / 2 < (int) options["Experience Book Max Moves"]
+                && config.experienceBook
+                && rootPos.game_ply() / 2 < config.experienceBookMaxMoves
                 && Experience::enabled())
             {
-                const auto  expBookMinDepth = Depth(options["Experience Book Min Depth"]);
-                const auto  expBookWidth    = uint32_t(options["Experience Book Width"]);
+                const auto  expBookMinDepth = Depth(config.experienceBookMinDepth);
+                const auto  expBookWidth    = uint32_t(config.experienceBookWidth);
                 const auto* exp             = Experience::probe(rootPos.key());
 
                 if (exp)
                 {
-                    const auto  evalImportance = int(options["Experience Book Eval Importance"]);
+                    const auto  evalImportance = config.experienceBookEvalImportance;
                     const auto* temp           = exp;
 
                     std::vector<std::pair<const Experience::ExpEntryEx*, int>> quality;
@@ -381,7 +426,7 @@ void Search::Worker::start_searching() {
                         // Apply BestMove (or random among the top 'widths')
                         if (expBookWidth > 1)
                         {
-                            static PRNG rng(now());
+                            PRNG& rng = main_manager()->rng;
                             bookMove = quality[rng.rand<uint32_t>()
                                                % std::min<uint32_t>(expBookWidth, quality.size())]
                                          .first->move;
@@ -404,8 +449,17 @@ void Search::Worker::start_searching() {
         }
         else
         {
+            main_manager()->expGuide.clear();
+#if defined(HYP_FIXED_ZOBRIST)
+            if (config.experienceGuidedSearch && Experience::enabled())
+                main_manager()->guide_by_experience(*this, threads);
+#endif
+            if (config.treeReuse)
+                main_manager()->reuse_tree(*this, threads, tt);
+
             threads.start_searching();  // start non-main threads
             iterative_deepening();      // main thread start searching
+            searched = true;
         }
     }
 
@@ -417,12 +471,21 @@ void Search::Worker::start_searching() {
     while (!threads.stop && (main_manager()->ponder || limits.infinite))
     {}  // Busy wait for a stop or a ponder reset
 
+    // With per-thread node budgets the helpers stop on their own quota, let
+    // them use it up so that the total is exactly the go nodes limit. Time is
+    // no longer checked here, so with a time limit too the main thread stops them.
+    if (nodeBudget != NoNodeBudget && !limits.use_time_management() && !limits.movetime)
+        threads.wait_for_search_finished();
+
     // Stop the threads if not already stopped (also raise the stop if
     // "ponderhit" just reset threads.ponder)
-    threads.stop = true;
+    main_manager()->stop_search(threads);
+    const TimePoint stopTime = main_manager()->stopTime;
 
     // Wait until all threads have finished
     threads.wait_for_search_finished();
+    publish_nodes();
+    const TimePoint joinTime = now();
 
 #if defined(HYP_FIXED_ZOBRIST)
     // Always write the PV to the Experience file even for single-run searches.
@@ -432,8 +495,8 @@ void Search::Worker::start_searching() {
     // partially-completed per-move analyses triggered by the viewer.
     if (!Experience::is_learning_paused()
         && !rootPos.is_chess960()
-        && !(bool) options["Experience Readonly"]
-        && !(bool) options["UCI_LimitStrength"]
+        && !config.experienceReadonly
+        && !config.limitStrength
         && !rootMoves.empty()
         && !rootMoves[0].pv.empty()
         && rootMoves[0].pv[0] != Move::none())
@@ -460,6 +523,8 @@ void Search::Worker::start_searching() {
     // Collect the first PV of each thread (skipping the overall best move),
     // merge duplicates by move, keep the highest depth for that move, and
     // average the scores when depth is equal. Then store as MultiPV experience.
+    // Readonly is checked on this engine's options, sessions share the tables.
+    if (!config.experienceReadonly)
     {
         struct UniqueMoveInfo {
             Move  move;     // root move
@@ -529,11 +594,12 @@ void Search::Worker::start_searching() {
             wrote_mpv = true;
         }
 
-        // Flush immediately if we wrote MultiPV entries (and not readonly)
-        if (wrote_mpv && !(bool)options["Experience Readonly"])
+        // Flush immediately if we wrote MultiPV entries
+        if (wrote_mpv)
             Experience::save();
     }
 #endif
+    const TimePoint ioTime = now();
 
     // When playing in 'nodes as time' mode, subtract the searched nodes from
     // the available ones before exiting.
@@ -542,20 +608,27 @@ void Search::Worker::start_searching() {
                                               - limits.inc[rootPos.side_to_move()]);
 
     Worker* bestThread = this;
-    Skill   skill =
-      Skill(options["Skill Level"], options["UCI_LimitStrength"] ? int(options["UCI_Elo"]) : 0);
+    Skill   skill      = Skill(config.skillLevel, config.limitStrength ? config.uciElo : 0);
 
-    if (int(options["MultiPV"]) == 1 && !limits.depth && !limits.mate && !skill.enabled()
-        && rootMoves[0].pv[0] != Move::none())
+    // Best thread voting would undo a move picked by Variety
+    if (config.multiPV == 1 && !limits.depth && !limits.mate && !skill.enabled()
+        && !main_manager()->varietyPicked && rootMoves[0].pv[0] != Move::none())
         bestThread = threads.get_best_thread()->worker.get();
 
     main_manager()->bestPreviousScore        = bestThread->rootMoves[0].score;
     main_manager()->bestPreviousAverageScore = bestThread->rootMoves[0].averageScore;
 
-    // Send again PV info if we have a new best thread
-    if (bestThread != this)
+    // Send again PV info if we have a new best thread, or with node budgets
+    // to report the exact total once all the helpers are done
+    if (bestThread != this || nodeBudget != NoNodeBudget)
         main_manager()->pv(*bestThread, threads, tt, bestThread->completedDepth);
 
+    if (config.treeReuse)
+        main_manager()->treeReuse.save(rootPos, bestThread->rootMoves[0],
+                                       bestThread->completedDepth);
+    else
+        main_manager()->treeReuse.clear();
+
     std::string ponder;
 
     if (bestThread->rootMoves[0].pv.size() > 1
@@ -563,6 +636,44 @@ void Search::Worker::start_searching() {
         ponder = UCIEngine::move(bestThread->rootMoves[0].pv[1], rootPos.is_chess960());
 
     auto bestmove = UCIEngine::move(bestThread->rootMoves[0].pv[0], rootPos.is_chess960());
+
+    // Report what following the experience was worth on this move
+    const ExperienceGuide& guide = main_manager()->expGuide;
+    if (searched && guide.move)
+        main_manager()->updates.onInfoString(
+          "Experience guide: "
+          + (bestThread->rootMoves[0].pv[0] == guide.move ? "search agreed"
+                                                           : "search preferred " + bestmove)
+          + ", time saved " + std::to_string(guide.savedTime) + " ms");
+
+#if defined(HYP_FIXED_ZOBRIST)
+    // Experience entries this search had to write into the TT
+    uint64_t injected = 0, reinjected = 0;
+    for (auto&& th : threads)
+    {
+        injected += th->worker->expInjected;
+        reinjected += th->worker->expReinjected;
+    }
+
+    if (injected + reinjected)
+        main_manager()->updates.onInfoString(
+          "Experience TT: " + std::to_string(injected) + " pinned, " + std::to_string(reinjected)
+          + " re-injected, " + std::to_string(tt.pinnedfull()) + " permille of clusters pinned");
+#endif
+
+    // Feed the stop to bestmove latency of real searches back into time management
+    if (config.adaptiveMoveOverhead && searched)
+    {
+        const TimePoint latency = now() - stopTime;
+        main_manager()->tm.add_latency(latency);
+
+        main_manager()->updates.onInfoString(
+          "Move latency " + std::to_string(latency) + " ms (join "
+          + std::to_string(joinTime - stopTime) + " ms, io " + std::to_string(ioTime - joinTime)
+          + " ms), Move Overhead now "
+          + std::to_string(main_manager()->tm.move_overhead(config)) + " ms");
+    }
+
     main_manager()->updates.onBestmove(bestmove, ponder);
 }
 
@@ -612,31 +723,31 @@ void Search::Worker::iterative_deepening() {
             mainThread->iterValue.fill(mainThread->bestPreviousScore);
     }
 
-    size_t multiPV = size_t(options["MultiPV"]);
-    Skill skill(options["Skill Level"], options["UCI_LimitStrength"] ? int(options["UCI_Elo"]) : 0);
+    size_t multiPV = config.multiPV;
+    Skill  skill(config.skillLevel, config.limitStrength ? config.uciElo : 0);
 
     // When playing with strength handicap enable MultiPV search that we will
     // use behind-the-scenes to retrieve a set of possible moves.
     if (skill.enabled())
         multiPV = std::max(multiPV, size_t(4));
 
+    Variety variety(config, rootPos);
+
     multiPV = std::min(multiPV, rootMoves.size());
 
     int searchAgainCounter = 0;
 
     lowPlyHistory.fill(97);
 
-    // Snapshot UCI options for fail-high/low info cadence (once per root search)
-    // Read once to avoid map lookups in the hot path and to keep values consistent
-    // for the whole root search (GUI changes take effect on the next search).
-    const bool     fi_enabled   = bool(options["FailInfo Enabled"]);
-    const int      fi_first_ms  = int(options["FailInfo First ms"]);
-    const uint64_t fi_min_nodes = uint64_t(int(options["FailInfo Min Nodes"]));
-    const int      fi_rate_ms   = int(options["FailInfo Rate ms"]);
+    // Fail-high/low info cadence, from the per-search option snapshot
+    const bool     fi_enabled   = config.failInfoEnabled;
+    const int      fi_first_ms  = config.failInfoFirstMs;
+    const uint64_t fi_min_nodes = config.failInfoMinNodes;
+    const int      fi_rate_ms   = config.failInfoRateMs;
     int64_t        fi_last_info_ms = -100000;   // rate limiter anchor (ms), reset at rootDepth == 1
 
     // Iterative deepening loop until requested to stop or the target depth is reached
-    while (++rootDepth < MAX_PLY && !threads.stop
+    while (++rootDepth < MAX_PLY && !stopped()
            && !(limits.depth && mainThread && rootDepth > limits.depth))
     {
         // Reset dynamic EMA at the start of each root iteration
@@ -713,7 +824,7 @@ void Search::Worker::iterative_deepening() {
                 // If search has been stopped, we break immediately. Sorting is
                 // safe because RootMoves is still valid, although it refers to
                 // the previous iteration.
-                if (threads.stop)
+                if (stopped())
                     break;
 
                 // On fail-high/low, emit an update before the re-search.
@@ -768,25 +879,25 @@ void Search::Worker::iterative_deepening() {
             std::stable_sort(rootMoves.begin() + pvFirst, rootMoves.begin() + pvIdx + 1);
 
             if (mainThread
-                && (threads.stop || pvIdx + 1 == multiPV || nodes > 10000000)
+                && (stopped() || pvIdx + 1 == multiPV || nodes > 10000000)
                 // A thread that aborted search can have mated-in/TB-loss PV and
                 // score that cannot be trusted, i.e. it can be delayed or refuted
                 // if we would have had time to fully search other root-moves. Thus
                 // we suppress this output and below pick a proven score/PV for this
                 // thread (from the previous iteration).
-                && !(threads.abortedSearch && is_loss(rootMoves[0].uciScore)))
+                && !((threads.abortedSearch || budgetReached) && is_loss(rootMoves[0].uciScore)))
                 main_manager()->pv(*this, threads, tt, rootDepth);
 
-            if (threads.stop)
+            if (stopped())
                 break;
         }
 
-        if (!threads.stop)
+        if (!stopped())
             completedDepth = rootDepth;
 
         // We make sure not to pick an unproven mated-in score,
         // in case this thread prematurely stopped search (aborted-search).
-        if (threads.abortedSearch && rootMoves[0].score != -VALUE_INFINITE
+        if ((threads.abortedSearch || budgetReached) && rootMoves[0].score != -VALUE_INFINITE
             && is_loss(rootMoves[0].score))
         {
             // Bring the last best move to the front for best thread selection.
@@ -816,7 +927,7 @@ void Search::Worker::iterative_deepening() {
 
         // If the skill level is enabled and time is up, pick a sub-optimal best move
         if (skill.enabled() && skill.time_to_pick(rootDepth))
-            skill.pick_best(rootMoves, multiPV);
+            skill.pick_best(rootMoves, multiPV, mainThread->rng);
 
         // Use part of the gained time from a previous stable move for the current move
         for (auto&& th : threads)
@@ -852,11 +963,20 @@ void Search::Worker::iterative_deepening() {
             if (rootMoves.size() == 1)
                 totalTime = std::min(502.0, totalTime);
 
+            // Spend less while the search agrees with well established experience
+            ExperienceGuide& guide  = mainThread->expGuide;
+            const bool       guided = guide.move == rootMoves[0].pv[0];
+            if (guided)
+            {
+                guide.fullTime = totalTime;
+                totalTime *= guide.timeScale;
+            }
+
             auto elapsedTime = elapsed();
 
             if (completedDepth >= 10 && nodesEffort >= 92425 && elapsedTime > totalTime * 0.666
                 && !mainThread->ponder)
-                threads.stop = true;
+                mainThread->stop_search(threads);
 
             // Stop the search if we have exceeded the totalTime or maximum
             if (elapsedTime > std::min(totalTime, double(mainThread->tm.maximum())))
@@ -866,10 +986,15 @@ void Search::Worker::iterative_deepening() {
                 if (mainThread->ponder)
                     mainThread->stopOnPonderhit = true;
                 else
-                    threads.stop = true;
+                    mainThread->stop_search(threads);
             }
             else
                 threads.increaseDepth = mainThread->ponder || elapsedTime <= totalTime * 0.503;
+
+            // Time the unscaled limit would still have given to this move
+            if (guided && (threads.stop || mainThread->stopOnPonderhit))
+                guide.savedTime = TimePoint(std::max(
+                  0.0, std::min(guide.fullTime, double(mainThread->tm.maximum())) - elapsedTime));
         }
 
         mainThread->iterValue[iterIdx] = bestValue;
@@ -885,7 +1010,26 @@ void Search::Worker::iterative_deepening() {
     if (skill.enabled())
         std::swap(rootMoves[0],
                   *std::find(rootMoves.begin(), rootMoves.end(),
-                             skill.best ? skill.best : skill.pick_best(rootMoves, multiPV)));
+                             skill.best ? skill.best
+                                        : skill.pick_best(rootMoves, multiPV, mainThread->rng)));
+
+    else if (variety.enabled())
+    {
+        RootMove& picked = *std::find(rootMoves.begin(), rootMoves.end(),
+                                      variety.pick(rootMoves, multiPV, threads.gamesStarted));
+
+        if (&picked != &rootMoves[0])
+        {
+            // Moves beyond the MultiPV lines only have a bound, they qualified
+            // with the exact score of the iteration they last led, which is
+            // what experience, tree reuse and time management get instead.
+            if (picked.score == -VALUE_INFINITE)
+                picked.score = picked.uciScore = picked.averageScore = picked.previousScore;
+
+            std::swap(rootMoves[0], picked);
+            mainThread->varietyPicked = true;
+        }
+    }
 }
 
 
@@ -897,7 +1041,12 @@ void Search::Worker::do_move(
   Position& pos, const Move move, StateInfo& st, const bool givesCheck, Stack* const ss) {
     bool       capture = pos.capture_stage(move);
     DirtyPiece dp      = pos.do_move(move, st, givesCheck, &tt);
-    nodes.fetch_add(1, std::memory_order_relaxed);
+    uint64_t   n       = nodes.load(std::memory_order_relaxed) + 1;
+    nodes.store(n, std::memory_order_relaxed);
+    if (n % NodesPublishInterval == 0)
+        publish_nodes();
+    if (n >= nodeBudget)
+        budgetReached = completedDepth >= 1;
     accumulatorStack.push(dp);
     if (ss != nullptr)
     {
@@ -909,6 +1058,18 @@ void Search::Worker::do_move(
 
 void Search::Worker::do_null_move(Position& pos, StateInfo& st) { pos.do_null_move(st, tt); }
 
+bool Search::Worker::stopped() const {
+    return threads.stop.load(std::memory_order_relaxed) || budgetReached;
+}
+
+// Adds the nodes counted since the last call to the NUMA node aggregate
+void Search::Worker::publish_nodes() {
+    uint64_t n = nodes.load(std::memory_order_relaxed);
+    nodeCounter->nodes.fetch_add(n - nodesPublished.load(std::memory_order_relaxed),
+                                 std::memory_order_relaxed);
+    nodesPublished.store(n, std::memory_order_relaxed);
+}
+
 void Search::Worker::undo_move(Position& pos, const Move move) {
     pos.undo_move(move);
     accumulatorStack.pop();
@@ -917,26 +1078,36 @@ void Search::Worker::undo_move(Position& pos, const Move move) {
 void Search::Worker::undo_null_move(Position& pos) { pos.undo_null_move(); }
 
 
-// Reset histories, usually before a new game
-void Search::Worker::clear() {
-    mainHistory.fill(68);
-    captureHistory.fill(-689);
-    pawnHistory.fill(-1238);
-    pawnCorrectionHistory.fill(5);
-    minorPieceCorrectionHistory.fill(0);
-    nonPawnCorrectionHistory.fill(0);
+namespace {
 
+// Sets every int16_t entry of a history table, however deeply nested, in one
+// flat pass that the compiler turns into wide vector stores.
+template<typename Table>
+void fill_entries(Table& table, std::int16_t v) {
+    static_assert(sizeof(Table) % sizeof(std::int16_t) == 0, "Not a table of int16_t");
+    std::fill_n(reinterpret_cast<std::int16_t*>(&table), sizeof(Table) / sizeof(std::int16_t),
+                v);
+}
+
+}
+
+void Histories::clear() {
     ttMoveHistory = 0;
 
-    for (auto& to : continuationCorrectionHistory)
-        for (auto& h : to)
-            h.fill(8);
+    fill_entries(mainHistory, 68);
+    fill_entries(captureHistory, -689);
+    fill_entries(pawnCorrectionHistory, 5);
+    fill_entries(minorPieceCorrectionHistory, 0);
+    fill_entries(nonPawnCorrectionHistory, 0);
+    fill_entries(continuationHistory, -529);
+    fill_entries(continuationCorrectionHistory, 8);
+    fill_entries(pawnHistory, -1238);
+}
 
-    for (bool inCheck : {false, true})
-        for (StatsType c : {NoCaptures, Captures})
-            for (auto& to : continuationHistory[inCheck][c])
-                for (auto& h : to)
-                    h.fill(-529);
+// Reset histories, usually before a new game. Each worker clears its own
+// tables on its own thread, see ThreadPool::clear().
+void Search::Worker::clear() {
+    Histories::clear();
 
     for (size_t i = 1; i < reductions.size(); ++i)
         reductions[i] = int(2809 / 128.0 * std::log(i));
@@ -1017,7 +1188,7 @@ Value Search::Worker::search(
     if (!rootNode)
     {
         // Step 2. Check for aborted search and immediate draw
-        if (threads.stop.load(std::memory_order_relaxed) || pos.is_draw(ss->ply)
+        if (stopped() || pos.is_draw(ss->ply)
             || ss->ply >= MAX_PLY)
             return (ss->ply >= MAX_PLY && !ss->inCheck) ? evaluate(pos) : value_draw(nodes);
 
@@ -1084,14 +1255,12 @@ Value Search::Worker::search(
                 ttData.bound = bnd;
                 ttData.depth = bestExp->depth;
 
-                ttWriter.write(posKey,
-                               value_to_tt(ttData.value, ss->ply),
-                               /*pv*/ true,
-                               bnd,
-                               ttData.depth,
-                               ttData.move,
-                               VALUE_NONE,
-                               tt.generation());
+                count_injection(ttWriter.write_experience(posKey,
+                                                          value_to_tt(ttData.value, ss->ply),
+                                                          bnd,
+                                                          ttData.depth,
+                                                          ttData.move,
+                                                          tt.generation()));
 
                 // Stop qui se PV
                 if constexpr (PvNode)
@@ -1172,14 +1341,12 @@ if constexpr (!PvNode)
             ttData.bound = (expValue >= beta ? BOUND_LOWER : BOUND_EXACT);
             ttCapture    = ttData.move && pos.capture_stage(ttData.move);
 
-            ttWriter.write(posKey,
-                           value_to_tt(expValue, ss->ply),
-                           /*pv*/ true,
-                           ttData.bound,
-                           expDepth,
-                           expMove,
-                           VALUE_NONE,
-                           tt.generation());
+            count_injection(ttWriter.write_experience(posKey,
+                                                      value_to_tt(expValue, ss->ply),
+                                                      ttData.bound,
+                                                      expDepth,
+                                                      expMove,
+                                                      tt.generation()));
         }
     }
 #endif
@@ -1440,6 +1607,9 @@ if constexpr (!PvNode)
 
             assert(pos.capture_stage(move));
 
+            if (budgetReached)
+                return VALUE_ZERO;
+
             do_move(pos, move, st, ss);
 
             // Perform a preliminary qsearch to verify that the move holds
@@ -1452,6 +1622,10 @@ if constexpr (!PvNode)
 
             undo_move(pos, move);
 
+            // Values searched past a used up node budget are not stored
+            if (budgetReached)
+                return VALUE_ZERO;
+
             if (value >= probCutBeta)
             {
                 // Save ProbCut data into transposition table
@@ -1666,6 +1840,10 @@ moves_loop:  // When in check, search starts here
                 extension = -2;
         }
 
+        // No move is made past a used up node budget, see qsearch()
+        if (budgetReached)
+            return VALUE_ZERO;
+
         // Step 16. Make the move
         do_move(pos, move, st, givesCheck, ss);
 
@@ -1780,7 +1958,7 @@ moves_loop:  // When in check, search starts here
         // Finished searching the move. If a stop occurred, the return value of
         // the search cannot be trusted, and we return immediately without updating
         // best move, principal variation nor transposition table.
-        if (threads.stop.load(std::memory_order_relaxed))
+        if (stopped())
             return VALUE_ZERO;
 
         if (rootNode)
@@ -2154,6 +2332,12 @@ Value Search::Worker::qsearch(Position& pos, Stack* ss, Value alpha, Value beta)
                 continue;
         }
 
+        // A worker that used up its node budget unwinds without making further
+        // moves, so that it searches exactly its quota. The value is discarded
+        // like on a stop.
+        if (budgetReached)
+            return VALUE_ZERO;
+
         // Step 7. Make and search the move
         do_move(pos, move, st, givesCheck, ss);
 
@@ -2162,6 +2346,11 @@ Value Search::Worker::qsearch(Position& pos, Stack* ss, Value alpha, Value beta)
 
         assert(value > -VALUE_INFINITE && value < VALUE_INFINITE);
 
+        // The child may have stopped on the node budget, so its value is not
+        // trusted and neither best move nor TT are updated with it.
+        if (budgetReached)
+            return VALUE_ZERO;
+
         // Step 8. Check for a new best move
         if (value > bestValue)
         {
@@ -2182,31 +2371,6 @@ Value Search::Worker::qsearch(Position& pos, Stack* ss, Value alpha, Value beta)
         }
     }
 
-    // --- Variety bonus (HypnoS) --------------------------------------------
-    // Small randomization of bestValue to increase move variety when
-    // evaluations are close and we are still in the opening phase.
-    // Uses per-worker cached config (this->varietyCfg).
-
-    const auto& cfg = this->varietyCfg;
-
-    if (cfg.enabled && std::abs(UCIEngine::to_cp(bestValue, pos)) < cfg.maxScore)
-    {
-        if (bestValue + cfg.enabled * PawnValue / 100 >= 0
-            && pos.game_ply() / 2 < cfg.maxMoves)
-        {
-            const auto varietyMinRange = nodes / 2;
-            const auto varietyMaxRange = nodes * 2;
-
-            thread_local PRNG rng(now());
-
-            bestValue += static_cast<Value>(
-                (rng.rand<std::uint64_t>() % (varietyMaxRange - varietyMinRange + 1)
-                 + varietyMinRange) % (cfg.enabled + 1)
-            );
-        }
-    }
-    // ------------------------------------------------------------------------
-
     // Step 9. Check for mate
     // All legal moves have been searched. A special case: if we are
     // in check and no legal moves were found, it is checkmate.
@@ -2414,9 +2578,8 @@ void update_quiet_histories(
 
 // When playing with strength handicap, choose the best move among a set of
 // RootMoves using a statistical rule dependent on 'level'. Idea by Heinz van Saanen.
-Move Skill::pick_best(const RootMoves& rootMoves, size_t multiPV) {
-    static PRNG rng(now());  // PRNG sequence should be non-deterministic
-
+// The PRNG is the one of the calling SearchManager, seeded non-deterministically.
+Move Skill::pick_best(const RootMoves& rootMoves, size_t multiPV, PRNG& rng) {
     // RootMoves are already sorted by score in descending order
     Value  topScore = rootMoves[0].score;
     int    delta    = std::min(topScore - rootMoves[multiPV - 1].score, int(PawnValue));
@@ -2444,6 +2607,46 @@ Move Skill::pick_best(const RootMoves& rootMoves, size_t multiPV) {
 }
 
 
+Variety::Variety(const SearchConfig& config, const Position& rootPos) :
+    window(rootPos.game_ply() / 2 < config.varietyMaxMoves ? config.variety * PawnValue / 100
+                                                           : 0),
+    maxScore(config.varietyMaxScore),
+    pos(rootPos) {}
+
+// Chooses among the root moves scoring within 'window' of the best one, more
+// likely the closer they are. Only exact scores count: those of the first
+// multiPV moves, and the previous iteration score of a move that led it, as
+// other root moves only have a bound. Only balanced, not losing positions qualify. The PRNG is seeded from the
+// game number and the root position, so a given game replays the same choices.
+Move Variety::pick(const RootMoves& rootMoves, size_t multiPV, uint64_t game) const {
+
+    const Value topScore = rootMoves[0].score;
+
+    if (std::abs(UCIEngine::to_cp(topScore, pos)) >= maxScore || topScore + window < 0)
+        return rootMoves[0].pv[0];
+
+    std::vector<int> weights(rootMoves.size());
+    int              total = 0;
+
+    for (size_t i = 0; i < rootMoves.size(); ++i)
+    {
+        const Value v = i < multiPV ? rootMoves[i].score : rootMoves[i].previousScore;
+
+        if (v != -VALUE_INFINITE && v <= topScore && topScore - v <= window)
+            total += weights[i] = window - (topScore - v) + 1;
+    }
+
+    PRNG rng(((game + 1) * 0x9E3779B97F4A7C15ULL ^ pos.key()) | 1);
+    int  r = int(rng.rand<uint64_t>() % uint64_t(total));
+
+    for (size_t i = 0; i < rootMoves.size(); ++i)
+        if ((r -= weights[i]) < 0)
+            return rootMoves[i].pv[0];
+
+    return rootMoves[0].pv[0];
+}
+
+
 // Used to print debug info and, more importantly, to detect
 // when we are out of available time and thus stop the search.
 void SearchManager::check_time(Search::Worker& worker) {
@@ -2474,23 +2677,37 @@ void SearchManager::check_time(Search::Worker& worker) {
       worker.completedDepth >= 1
       && ((worker.limits.use_time_management() && (elapsed > tm.maximum() || stopOnPonderhit))
           || (worker.limits.movetime && elapsed >= worker.limits.movetime)
-          || (worker.limits.nodes && worker.threads.nodes_searched() >= worker.limits.nodes)))
-        worker.threads.stop = worker.threads.abortedSearch = true;
+          || (worker.limits.nodes && worker.nodeBudget == NoNodeBudget
+              && worker.threads.nodes_searched() >= worker.limits.nodes)))
+        stop_search(worker.threads, true);
+}
+
+// Raises the stop and remembers when, so that the bestmove latency measured
+// for 'Adaptive Move Overhead' includes unwinding. Called by the main thread
+// and by the UCI thread on 'stop', whichever comes first sets the time.
+void SearchManager::stop_search(ThreadPool& threads, bool aborted) {
+    TimePoint unset = 0;
+    stopTime.compare_exchange_strong(unset, now());
+
+    if (aborted)
+        threads.abortedSearch = true;
+    threads.stop = true;
 }
 
 // Used to correct and extend PVs for moves that have a TB (but not a mate) score.
 // Keeps the search based PV for as long as it is verified to maintain the game
 // outcome, truncates afterwards. Finally, extends to mate the PV, providing a
 // possible continuation (but not a proven mating line).
-void syzygy_extend_pv(const OptionsMap&         options,
+void syzygy_extend_pv(const SearchConfig&       searchConfig,
                       const Search::LimitsType& limits,
+                      TimePoint                 moveOverhead,
                       Position&                 pos,
                       RootMove&                 rootMove,
-                      Value&                    v) {
+                      Value&                    v,
+                      SyzygyPVCache&            cache) {
 
-    auto t_start      = std::chrono::steady_clock::now();
-    int  moveOverhead = int(options["Move Overhead"]);
-    bool rule50       = bool(options["Syzygy50MoveRule"]);
+    auto t_start = std::chrono::steady_clock::now();
+    bool rule50  = searchConfig.syzygy.useRule50;
 
     // Do not use more than moveOverhead / 2 time, if time management is active
     auto time_abort = [&t_start, &moveOverhead, &limits]() -> bool {
@@ -2500,6 +2717,27 @@ void syzygy_extend_pv(const OptionsMap&         options,
                  > moveOverhead;
     };
 
+    // Results depend on the rule50 counter, on the probing setup and, through
+    // the repetition checks of root probing, on the positions since the last
+    // irreversible move, not only on the position itself.
+    auto cache_key = [&](Move m) {
+        Key k = pos.key() ^ make_key(uint64_t(pos.rule50_count()) << 1 | rule50)
+              ^ make_key((uint64_t(m.raw()) << 8) | uint64_t(Tablebases::MaxCardinality));
+
+        const StateInfo* st  = pos.state();
+        const int        end = std::min(st->rule50, st->pliesFromNull);
+        for (int i = 0; i < end && st->previous; ++i)
+        {
+            st = st->previous;
+            k  = make_key(k ^ st->key);
+        }
+        return k;
+    };
+
+    if (cache.rankCheck.size() > SyzygyPVCache::MaxEntries
+        || cache.nextMove.size() > SyzygyPVCache::MaxEntries)
+        cache.clear();
+
     std::list<StateInfo> sts;
 
     // Step 0, do the rootMove, no correction allowed, as needed for MultiPV in TB.
@@ -2511,15 +2749,27 @@ void syzygy_extend_pv(const OptionsMap&         options,
     while (size_t(ply) < rootMove.pv.size())
     {
         Move& pvMove = rootMove.pv[ply];
+        Key   key    = cache_key(pvMove);
 
-        RootMoves legalMoves;
-        for (const auto& m : MoveList<LEGAL>(pos))
-            legalMoves.emplace_back(m);
+        auto it = cache.rankCheck.find(key);
+        if (it == cache.rankCheck.end())
+        {
+            RootMoves legalMoves;
+            for (const auto& m : MoveList<LEGAL>(pos))
+                legalMoves.emplace_back(m);
+
+            Tablebases::Config config =
+              Tablebases::rank_root_moves(searchConfig.syzygy, pos, legalMoves);
+            RootMove& rm = *std::find(legalMoves.begin(), legalMoves.end(), pvMove);
 
-        Tablebases::Config config = Tablebases::rank_root_moves(options, pos, legalMoves);
-        RootMove&          rm     = *std::find(legalMoves.begin(), legalMoves.end(), pvMove);
+            it = cache.rankCheck
+                   .emplace(key, uint8_t((legalMoves[0].tbRank == rm.tbRank) | config.rootInTB << 1))
+                   .first;
+        }
 
-        if (legalMoves[0].tbRank != rm.tbRank)
+        bool rootInTB = it->second & 2;
+
+        if (!(it->second & 1))
             break;
 
         ply++;
@@ -2528,7 +2778,7 @@ void syzygy_extend_pv(const OptionsMap&         options,
         pos.do_move(pvMove, st);
 
         // Do not allow for repetitions or drawing moves along the PV in TB regime
-        if (config.rootInTB && ((rule50 && pos.is_draw(ply)) || pos.is_repetition(ply)))
+        if (rootInTB && ((rule50 && pos.is_draw(ply)) || pos.is_repetition(ply)))
         {
             pos.undo_move(pvMove);
             ply--;
@@ -2537,7 +2787,7 @@ void syzygy_extend_pv(const OptionsMap&         options,
 
         // Full PV shown will thus be validated and end in TB.
         // If we cannot validate the full PV in time, we do not show it.
-        if (config.rootInTB && time_abort())
+        if (rootInTB && time_abort())
             break;
     }
 
@@ -2546,45 +2796,60 @@ void syzygy_extend_pv(const OptionsMap&         options,
 
     // Step 2, now extend the PV to mate, as if the user explored syzygy-tables.info
     // using top ranked moves (minimal DTZ), which gives optimal mates only for simple
-    // endgames e.g. KRvK.
-    while (!(rule50 && pos.is_draw(0)))
+    // endgames e.g. KRvK. Positions already walked are replayed from the cache, and
+    // the walk is bounded by MAX_PLY.
+    while (!(rule50 && pos.is_draw(0)) && ply < MAX_PLY)
     {
-        if (time_abort())
-            break;
+        Key  key = cache_key(Move::none());
+        auto it  = cache.nextMove.find(key);
 
-        RootMoves legalMoves;
-        for (const auto& m : MoveList<LEGAL>(pos))
+        if (it == cache.nextMove.end())
         {
-            auto&     rm = legalMoves.emplace_back(m);
-            StateInfo tmpSI;
-            pos.do_move(m, tmpSI);
-            // Give a score of each move to break DTZ ties restricting opponent mobility,
-            // but not giving the opponent a capture.
-            for (const auto& mOpp : MoveList<LEGAL>(pos))
-                rm.tbRank -= pos.capture(mOpp) ? 100 : 1;
-            pos.undo_move(m);
-        }
+            if (time_abort())
+                break;
 
-        // Mate found
-        if (legalMoves.size() == 0)
-            break;
+            RootMoves legalMoves;
+            for (const auto& m : MoveList<LEGAL>(pos))
+            {
+                auto&     rm = legalMoves.emplace_back(m);
+                StateInfo tmpSI;
+                pos.do_move(m, tmpSI);
+                // Give a score of each move to break DTZ ties restricting opponent mobility,
+                // but not giving the opponent a capture.
+                for (const auto& mOpp : MoveList<LEGAL>(pos))
+                    rm.tbRank -= pos.capture(mOpp) ? 100 : 1;
+                pos.undo_move(m);
+            }
 
-        // Sort moves according to their above assigned rank.
-        // This will break ties for moves with equal DTZ in rank_root_moves.
-        std::stable_sort(
-          legalMoves.begin(), legalMoves.end(),
-          [](const Search::RootMove& a, const Search::RootMove& b) { return a.tbRank > b.tbRank; });
+            Move best = Move::none();
 
-        // The winning side tries to minimize DTZ, the losing side maximizes it
-        Tablebases::Config config = Tablebases::rank_root_moves(options, pos, legalMoves, true);
+            // No move means mate found, otherwise sort moves according to their above
+            // assigned rank. This will break ties for moves with equal DTZ in rank_root_moves.
+            if (legalMoves.size())
+            {
+                std::stable_sort(legalMoves.begin(), legalMoves.end(),
+                                 [](const Search::RootMove& a, const Search::RootMove& b) {
+                                     return a.tbRank > b.tbRank;
+                                 });
+
+                // The winning side tries to minimize DTZ, the losing side maximizes it
+                Tablebases::Config config =
+                  Tablebases::rank_root_moves(searchConfig.syzygy, pos, legalMoves, true);
+
+                // If DTZ is not available we might not find a mate, so we bail out
+                if (config.rootInTB && config.cardinality == 0)
+                    best = legalMoves[0].pv[0];
+            }
 
-        // If DTZ is not available we might not find a mate, so we bail out
-        if (!config.rootInTB || config.cardinality > 0)
+            it = cache.nextMove.emplace(key, best).first;
+        }
+
+        if (it->second == Move::none())
             break;
 
         ply++;
 
-        Move& pvMove = legalMoves[0].pv[0];
+        Move pvMove = it->second;
         rootMove.pv.push_back(pvMove);
         auto& st = sts.emplace_back();
         pos.do_move(pvMove, st);
@@ -2623,7 +2888,7 @@ void SearchManager::pv(Search::Worker&           worker,
     auto&      rootMoves = worker.rootMoves;
     auto&      pos       = worker.rootPos;
     size_t     pvIdx     = worker.pvIdx;
-    size_t     multiPV   = std::min(size_t(worker.options["MultiPV"]), rootMoves.size());
+    size_t     multiPV   = std::min(worker.config.multiPV, rootMoves.size());
     uint64_t   tbHits    = threads.tb_hits() + (worker.tbConfig.rootInTB ? rootMoves.size() : 0);
 
     for (size_t i = 0; i < multiPV; ++i)
@@ -2647,7 +2912,8 @@ void SearchManager::pv(Search::Worker&           worker,
         // Potentially correct and extend the PV, and in exceptional cases v
         if (is_decisive(v) && std::abs(v) < VALUE_MATE_IN_MAX_PLY
             && ((!rootMoves[i].scoreLowerbound && !rootMoves[i].scoreUpperbound) || isExact))
-            syzygy_extend_pv(worker.options, worker.limits, pos, rootMoves[i], v);
+            syzygy_extend_pv(worker.config, worker.limits, tm.move_overhead(worker.config), pos,
+                             rootMoves[i], v, tbPvCache);
 
         std::string pv;
         for (Move m : rootMoves[i].pv)
@@ -2683,6 +2949,165 @@ void SearchManager::pv(Search::Worker&           worker,
     }
 }
 
+void TreeReuse::save(Position& pos, const RootMove& rm, Depth completedDepth) {
+
+    clear();
+
+    if (rm.pv.size() < 3)
+        return;
+
+    StateInfo st[2];
+    pos.do_move(rm.pv[0], st[0]);
+    pos.do_move(rm.pv[1], st[1]);
+    key = pos.key();
+    pos.undo_move(rm.pv[1]);
+    pos.undo_move(rm.pv[0]);
+
+    pv.assign(rm.pv.begin() + 2, rm.pv.end());
+    depth = completedDepth - 2;
+
+    // Same side to move two plies later, mate distances would be off by one move
+    score = is_decisive(rm.score) ? VALUE_NONE : rm.score;
+}
+
+// If the root is the position the previous search predicted, move its best
+// reply to the front of every thread's root moves with the remaining PV and
+// seed the aspiration window with the previous score.
+void SearchManager::reuse_tree(Search::Worker&           worker,
+                               ThreadPool&               threads,
+                               const TranspositionTable& tt) {
+
+    Position& pos = worker.rootPos;
+
+    if (!treeReuse.key || treeReuse.key != pos.key() || worker.tbConfig.rootInTB
+        || std::find(worker.rootMoves.begin(), worker.rootMoves.end(), treeReuse.pv[0])
+             == worker.rootMoves.end())
+        return;
+
+    // Keep only the part of the PV that is still legal from here
+    std::vector<StateInfo> sts(treeReuse.pv.size());
+    size_t                 len = 0;
+
+    while (len < treeReuse.pv.size() && pos.pseudo_legal(treeReuse.pv[len])
+           && pos.legal(treeReuse.pv[len]))
+    {
+        pos.do_move(treeReuse.pv[len], sts[len]);
+        ++len;
+    }
+
+    for (size_t i = len; i > 0; --i)
+        pos.undo_move(treeReuse.pv[i - 1]);
+
+    if (!len)
+        return;
+
+    for (auto&& th : threads)
+    {
+        auto& rms = th->worker->rootMoves;
+        auto  it  = std::find(rms.begin(), rms.end(), treeReuse.pv[0]);
+        std::rotate(rms.begin(), it, it + 1);
+
+        rms[0].pv.assign(treeReuse.pv.begin(), treeReuse.pv.begin() + len);
+
+        if (treeReuse.score != VALUE_NONE)
+        {
+            rms[0].previousScore = rms[0].averageScore = treeReuse.score;
+            rms[0].meanSquaredScore = treeReuse.score * std::abs(treeReuse.score);
+        }
+    }
+
+    // How much of the previous work is still available: the TT depth at the root
+    // and how many of the replies to our root moves have a TT entry.
+    auto [rootHit, rootData, rootWriter] = tt.probe(pos.key());
+    size_t hits                          = 0;
+
+    for (const auto& rm : worker.rootMoves)
+    {
+        StateInfo st;
+        pos.do_move(rm.pv[0], st, &tt);
+        hits += std::get<0>(tt.probe(pos.key()));
+        pos.undo_move(rm.pv[0]);
+    }
+
+    std::stringstream ss;
+    ss << "Tree reuse: " << UCIEngine::move(treeReuse.pv[0], pos.is_chess960()) << " pv " << len
+       << " plies from depth " << treeReuse.depth << ", TT root depth "
+       << (rootHit ? rootData.depth : 0) << ", " << hits << "/" << worker.rootMoves.size()
+       << " root replies in TT";
+    updates.onInfoString(ss.str());
+}
+
+#if defined(HYP_FIXED_ZOBRIST)
+// Deep experience at the root orders the root moves of every thread best
+// first and seeds the aspiration window of the best one with its stored score.
+// When no other experience move at a comparable depth comes close, the time
+// limits are scaled down for as long as the search prefers the same move.
+void SearchManager::guide_by_experience(Search::Worker& worker, ThreadPool& threads) {
+
+    constexpr Depth GuideMinDepth = 16;  // Experience deeper than early iterations
+    constexpr Value GuideMargin   = 40;  // Lead over the other experience moves
+    constexpr int   ScaleDepth    = 20;  // Depths above GuideMinDepth for full scaling
+    constexpr double MaxSaving    = 0.4;
+
+    Position& pos = worker.rootPos;
+    auto&     rms = worker.rootMoves;
+
+    if (worker.tbConfig.rootInTB)
+        return;
+
+    std::vector<const Experience::ExpEntryEx*> entries;
+    for (auto* exp = Experience::probe(pos.key()); exp; exp = exp->next)
+        if (exp->depth >= GuideMinDepth && std::find(rms.begin(), rms.end(), exp->move) != rms.end())
+            entries.push_back(exp);
+
+    if (entries.empty())
+        return;
+
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const auto* a, const auto* b) { return a->compare(b) > 0; });
+
+    const auto* best = entries[0];
+    const bool  seed = !is_decisive(best->value);
+
+    for (auto&& th : threads)
+    {
+        auto& thRms = th->worker->rootMoves;
+
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+        {
+            auto rm = std::find(thRms.begin(), thRms.end(), (*it)->move);
+            std::rotate(thRms.begin(), rm, rm + 1);
+        }
+
+        if (seed)
+        {
+            thRms[0].previousScore = thRms[0].averageScore = best->value;
+            thRms[0].meanSquaredScore = best->value * std::abs(best->value);
+        }
+    }
+
+    expGuide.move  = best->move;
+    expGuide.value = best->value;
+    expGuide.depth = best->depth;
+
+    const bool contested =
+      std::any_of(entries.begin() + 1, entries.end(), [&](const auto* exp) {
+          return 2 * exp->depth >= best->depth && exp->value > best->value - GuideMargin;
+      });
+
+    if (seed && !contested)
+        expGuide.timeScale =
+          1.0 - MaxSaving * std::min(1.0, double(best->depth - GuideMinDepth) / ScaleDepth);
+
+    std::stringstream ss;
+    ss << "Experience guide: " << UCIEngine::move(best->move, pos.is_chess960()) << " depth "
+       << best->depth << " score cp " << UCIEngine::to_cp(best->value, pos) << ", "
+       << entries.size() << " experience moves first, time limit "
+       << int(100 * expGuide.timeScale) << "%";
+    updates.onInfoString(ss.str());
+}
+#endif
+
 // Called in case we have no ponder move before exiting the search,
 // for instance, in case we stop the search during a fail high at root.
 // We try hard to have a ponder move to return to the GUI,
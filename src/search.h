@@ -29,6 +29,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "history.h"
@@ -117,7 +118,7 @@ struct LimitsType {
         time[WHITE] = time[BLACK] = inc[WHITE] = inc[BLACK] = npmsec = movetime = TimePoint(0);
         movestogo = depth = mate = perft = infinite = 0;
         nodes                                       = 0;
-        ponderMode                                  = false;
+        ponderMode = perftStats                     = false;
     }
 
     bool use_time_management() const { return time[WHITE] || time[BLACK]; }
@@ -126,7 +127,60 @@ struct LimitsType {
     TimePoint                time[COLOR_NB], inc[COLOR_NB], npmsec, movetime, startTime;
     int                      movestogo, depth, mate, perft, infinite;
     uint64_t                 nodes;
-    bool                     ponderMode;
+    bool                     ponderMode, perftStats;
+};
+
+
+// SearchConfig is a typed snapshot of the UCI options read by the search. The
+// engine rebuilds it on every option change and publishes it atomically, and
+// each search copies it into its workers, so no option map lookups are done
+// while searching and a concurrent setoption only affects the next search.
+struct SearchConfig {
+    SearchConfig() = default;
+    explicit SearchConfig(const OptionsMap& options);
+
+    size_t multiPV       = 1;
+    int    skillLevel    = 20;
+    int    uciElo        = 0;
+    bool   limitStrength = false;
+    bool   ponder        = false;
+    bool   treeReuse     = false;
+    bool   logWeights    = false;
+
+    // Time management
+    int  moveOverhead         = 0;
+    bool adaptiveMoveOverhead = false;
+    int  minimumThinkingTime  = 0;
+    int  slowMover            = 100;
+    int  nodestime            = 0;
+    bool nodesPerThread       = false;
+
+    // Polyglot books, indexed by book number minus one
+    bool book[2]         = {};
+    bool bookBestMove[2] = {};
+    int  bookDepth[2]    = {};
+    int  bookWidth[2]    = {};
+
+    // Experience
+    bool experienceReadonly           = false;
+    bool experienceBook               = false;
+    int  experienceBookWidth          = 1;
+    int  experienceBookEvalImportance = 0;
+    int  experienceBookMinDepth       = 0;
+    int  experienceBookMaxMoves       = 0;
+    bool experienceGuidedSearch       = false;
+
+    int variety         = 0;
+    int varietyMaxScore = 0;
+    int varietyMaxMoves = 0;
+
+    bool     failInfoEnabled  = false;
+    int      failInfoFirstMs  = 0;
+    uint64_t failInfoMinNodes = 0;
+    int      failInfoRateMs   = 0;
+
+    // Syzygy probing setup, rootInTB is filled in per search
+    Tablebases::Config syzygy;
 };
 
 
@@ -148,6 +202,18 @@ struct SharedState {
     const LazyNumaReplicated<Eval::NNUE::Networks>& networks;
 };
 
+// Nodes published by the workers bound to one NUMA node, on its own cache
+// line. Workers count privately and add to their slot every
+// NodesPublishInterval nodes, so node polling reads one slot per NUMA node.
+struct alignas(64) NodeCounter {
+    std::atomic<uint64_t> nodes{0};
+};
+
+constexpr uint64_t NodesPublishInterval = 1024;
+
+// Node quota of a worker when 'Nodes Per Thread' does not split a go nodes limit
+constexpr uint64_t NoNodeBudget = ~uint64_t(0);
+
 class Worker;
 
 // Null Object Pattern, implement a common interface for the SearchManagers.
@@ -204,12 +270,77 @@ struct Skill {
     }
     bool enabled() const { return level < 20.0; }
     bool time_to_pick(Depth depth) const { return depth == 1 + int(level); }
-    Move pick_best(const RootMoves&, size_t multiPV);
+    Move pick_best(const RootMoves&, size_t multiPV, PRNG& rng);
 
     double level;
     Move   best = Move::none();
 };
 
+// Variety makes opening play less repetitive by playing, instead of the best
+// move, one drawn among the root moves scoring within 'Variety' centipawns of
+// it. The search itself is untouched: candidates are the root moves with an
+// exact score, the MultiPV lines and the move that led the previous iteration,
+// and the draw is reproducible for a given game.
+struct Variety {
+    Variety(const SearchConfig& config, const Position& rootPos);
+    bool enabled() const { return window > 0; }
+    Move pick(const RootMoves&, size_t multiPV, uint64_t game) const;
+
+    int             window;
+    int             maxScore;
+    const Position& pos;
+};
+
+// SyzygyPVCache memoizes the tablebase walk done by syzygy_extend_pv(). Entries
+// are keyed by position key mixed with the rule50 counter and the positions
+// since the last irreversible move, which root probing checks for repetitions,
+// so they stay valid across the many pv() calls of a search and across moves
+// of the same game.
+struct SyzygyPVCache {
+    static constexpr size_t MaxEntries = 1 << 16;
+
+    void clear() {
+        rankCheck.clear();
+        nextMove.clear();
+    }
+
+    // PV move keeps the best TB rank (bit 0) / position is in TB (bit 1)
+    std::unordered_map<Key, uint8_t> rankCheck;
+    // Top ranked move towards mate, Move::none() when the walk ends here
+    std::unordered_map<Key, Move> nextMove;
+};
+
+// TreeReuse keeps the tail of the previous best PV, keyed by the position it
+// predicts two plies later, after our move and the expected reply (the ponder
+// move). If the game continues that way the next search starts from it.
+struct TreeReuse {
+    void clear() {
+        key = 0;
+        pv.clear();
+    }
+
+    void save(Position& pos, const RootMove& rm, Depth completedDepth);
+
+    Key               key = 0;
+    std::vector<Move> pv;
+    Value             score = VALUE_NONE;
+    Depth             depth = 0;
+};
+
+// ExperienceGuide is what the experience of the root position says before the
+// search starts: the move searched first, its stored score and depth, and the
+// factor applied to the time limits while the search keeps preferring it.
+struct ExperienceGuide {
+    void clear() { *this = ExperienceGuide(); }
+
+    Move      move      = Move::none();
+    Value     value     = VALUE_NONE;
+    Depth     depth     = 0;
+    double    timeScale = 1.0;
+    double    fullTime  = 0;  // Last time limit before scaling
+    TimePoint savedTime = 0;
+};
+
 // SearchManager manages the search from the main thread. It is responsible for
 // keeping track of the time, and storing data strictly related to the main thread.
 class SearchManager: public ISearchManager {
@@ -218,12 +349,14 @@ class SearchManager: public ISearchManager {
     using UpdateFull     = std::function<void(const InfoFull&)>;
     using UpdateIter     = std::function<void(const InfoIteration&)>;
     using UpdateBestmove = std::function<void(std::string_view, std::string_view)>;
+    using UpdateString   = std::function<void(std::string_view)>;
 
     struct UpdateContext {
         UpdateShort    onUpdateNoMoves;
         UpdateFull     onUpdateFull;
         UpdateIter     onIter;
         UpdateBestmove onBestmove;
+        UpdateString   onInfoString;
     };
 
 
@@ -231,22 +364,33 @@ class SearchManager: public ISearchManager {
         updates(updateContext) {}
 
     void check_time(Search::Worker& worker) override;
+    void stop_search(ThreadPool& threads, bool aborted = false);
 
     void pv(Search::Worker&           worker,
             const ThreadPool&         threads,
             const TranspositionTable& tt,
             Depth                     depth);
 
+    void reuse_tree(Search::Worker& worker, ThreadPool& threads, const TranspositionTable& tt);
+    void guide_by_experience(Search::Worker& worker, ThreadPool& threads);
+
     Hypnos::TimeManagement tm;
     double                    originalTimeAdjust;
     int                       callsCnt;
     std::atomic_bool          ponder;
 
-    std::array<Value, 4> iterValue;
-    double               previousTimeReduction;
-    Value                bestPreviousScore;
-    Value                bestPreviousAverageScore;
-    bool                 stopOnPonderhit;
+    std::array<Value, 4>   iterValue;
+    double                 previousTimeReduction;
+    Value                  bestPreviousScore;
+    Value                  bestPreviousAverageScore;
+    bool                   stopOnPonderhit;
+    bool                   varietyPicked;  // Variety replaced the best move of this search
+    std::atomic<TimePoint> stopTime;  // When the stop was raised, or 0
+    SyzygyPVCache          tbPvCache;
+    TreeReuse              treeReuse;
+    ExperienceGuide        expGuide;
+    bool                   ageTT       = true;  // Off when the caller ages the shared TT
+    PRNG                   rng{uint64_t(now()) ^ uint64_t(uintptr_t(this))};
 
     size_t id;
 
@@ -261,8 +405,9 @@ class NullSearchManager: public ISearchManager {
 
 // Search::Worker is the class that does the actual search.
 // It is instantiated once per thread, and it is responsible for keeping track
-// of the search history, and storing data required for the search.
-class Worker {
+// of the search history, and storing data required for the search. The
+// history tables are public because they need to be updatable by the stats.
+class Worker: public Histories {
    public:
     Worker(SharedState&, std::unique_ptr<ISearchManager>, size_t, NumaReplicatedAccessToken);
 
@@ -278,21 +423,6 @@ class Worker {
 
     void ensure_network_replicated();
 
-    // Public because they need to be updatable by the stats
-    ButterflyHistory mainHistory;
-    LowPlyHistory    lowPlyHistory;
-
-    CapturePieceToHistory captureHistory;
-    ContinuationHistory   continuationHistory[2][2];
-    PawnHistory           pawnHistory;
-
-    CorrectionHistory<Pawn>         pawnCorrectionHistory;
-    CorrectionHistory<Minor>        minorPieceCorrectionHistory;
-    CorrectionHistory<NonPawn>      nonPawnCorrectionHistory;
-    CorrectionHistory<Continuation> continuationCorrectionHistory;
-
-    TTMoveHistory ttMoveHistory;
-
    private:
     void iterative_deepening();
 
@@ -300,6 +430,7 @@ class Worker {
     void
     do_move(Position& pos, const Move move, StateInfo& st, const bool givesCheck, Stack* const ss);
     void do_null_move(Position& pos, StateInfo& st);
+    void publish_nodes();
     void undo_move(Position& pos, const Move move);
     void undo_null_move(Position& pos);
 
@@ -328,8 +459,28 @@ class Worker {
 
     size_t                pvIdx, pvLast;
     std::atomic<uint64_t> nodes, tbHits, bestMoveChanges;
+
+    // Only this worker writes 'nodes', so it is bumped with a plain load and
+    // store. nodesPublished is the part already added to *nodeCounter.
+    std::atomic<uint64_t> nodesPublished;
+    NodeCounter*          nodeCounter = nullptr;
     int                   selDepth, nmpMinPly;
 
+    // With 'Nodes Per Thread', go nodes is split into per-worker quotas. A
+    // worker that used its quota up stops on its own, without stopping others.
+    uint64_t nodeBudget    = NoNodeBudget;
+    bool     budgetReached = false;
+    bool     stopped() const;
+
+    // Experience entries written into the TT, newly pinned or written again
+    // while still pinned for the same position. Only this worker writes them,
+    // so like 'nodes' they are bumped with a plain load and store.
+    std::atomic<uint64_t> expInjected, expReinjected;
+    void                  count_injection(bool again) {
+        auto& counter = again ? expReinjected : expInjected;
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
     Value optimism[COLOR_NB];
 
     Position  rootPos;
@@ -341,16 +492,6 @@ class Worker {
     size_t                    threadIdx;
     NumaReplicatedAccessToken numaAccessToken;
 
-    // --- HypnoS: per-worker Variety config cache ----------------------------
-    struct VarietyCfg {
-        int enabled  = 0;   // UCI: Variety
-        int maxScore = 50;  // UCI: Variety Max Score
-        int maxMoves = 12;  // UCI: Variety Max Moves
-    };
-
-    VarietyCfg varietyCfg;
-    // ------------------------------------------------------------------------
-
     // Reductions lookup table initialized at startup
     std::array<int, MAX_MOVES> reductions;  // [depth or moveNumber]
 
@@ -358,6 +499,7 @@ class Worker {
     std::unique_ptr<ISearchManager> manager;
 
     Tablebases::Config tbConfig;
+    SearchConfig       config;
 
     const OptionsMap&                               options;
     ThreadPool&                                     threads;
@@ -42,7 +42,6 @@
 #include "../position.h"
 #include "../search.h"
 #include "../types.h"
-#include "../ucioption.h"
 
 #ifndef _WIN32
     #include <fcntl.h>
@@ -1705,7 +1704,9 @@ bool Tablebases::root_probe_wdl(Position& pos, Search::RootMoves& rootMoves, boo
     return true;
 }
 
-Config Tablebases::rank_root_moves(const OptionsMap&  options,
+// The probing setup (rule50, probe depth and limit) comes from 'setup', the
+// returned config also tells whether the root position is in the tablebases.
+Config Tablebases::rank_root_moves(const Config&      setup,
                                    Position&          pos,
                                    Search::RootMoves& rootMoves,
                                    bool               rankDTZ) {
@@ -1714,10 +1715,8 @@ Config Tablebases::rank_root_moves(const OptionsMap&  options,
     if (rootMoves.empty())
         return config;
 
-    config.rootInTB    = false;
-    config.useRule50   = bool(options["Syzygy50MoveRule"]);
-    config.probeDepth  = int(options["SyzygyProbeDepth"]);
-    config.cardinality = int(options["SyzygyProbeLimit"]);
+    config          = setup;
+    config.rootInTB = false;
 
     bool dtz_available = true;
 
@@ -1732,13 +1731,13 @@ Config Tablebases::rank_root_moves(const OptionsMap&  options,
     if (config.cardinality >= popcount(pos.pieces()) && !pos.can_castle(ANY_CASTLING))
     {
         // Rank moves using DTZ tables
-        config.rootInTB = root_probe(pos, rootMoves, options["Syzygy50MoveRule"], rankDTZ);
+        config.rootInTB = root_probe(pos, rootMoves, config.useRule50, rankDTZ);
 
         if (!config.rootInTB)
         {
             // DTZ tables are missing; try to rank moves using WDL tables
             dtz_available   = false;
-            config.rootInTB = root_probe_wdl(pos, rootMoves, options["Syzygy50MoveRule"]);
+            config.rootInTB = root_probe_wdl(pos, rootMoves, config.useRule50);
         }
     }
 
@@ -25,7 +25,6 @@
 
 namespace Hypnos {
 class Position;
-class OptionsMap;
 
 using Depth = int;
 
@@ -68,7 +67,7 @@ WDLScore probe_wdl(Position& pos, ProbeState* result);
 int      probe_dtz(Position& pos, ProbeState* result);
 bool     root_probe(Position& pos, Search::RootMoves& rootMoves, bool rule50, bool rankDTZ);
 bool     root_probe_wdl(Position& pos, Search::RootMoves& rootMoves, bool rule50);
-Config   rank_root_moves(const OptionsMap&  options,
+Config   rank_root_moves(const Config&      setup,
                          Position&          pos,
                          Search::RootMoves& rootMoves,
                          bool               rankDTZ = false);
@@ -20,9 +20,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <deque>
 #include <memory>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 
@@ -114,7 +116,21 @@ void Thread::idle_loop() {
         std::unique_lock<std::mutex> lk(mutex);
         searching = false;
         cv.notify_one();  // Wake up anyone waiting for search finished
-        cv.wait(lk, [&] { return searching; });
+
+        // A job arriving while we spin starts without a futex wakeup, which
+        // matters for back to back searches such as bullet games and ponderhit.
+        if (int spin = spinMicros.load(std::memory_order_relaxed))
+        {
+            lk.unlock();
+
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(spin);
+            while (!searching && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::yield();
+
+            lk.lock();
+        }
+
+        cv.wait(lk, [&] { return bool(searching); });
 
         if (exit)
             return;
@@ -131,7 +147,21 @@ void Thread::idle_loop() {
 
 Search::SearchManager* ThreadPool::main_manager() { return main_thread()->worker->main_manager(); }
 
-uint64_t ThreadPool::nodes_searched() const { return accumulate(&Search::Worker::nodes); }
+// Sums the NUMA node aggregates. The main thread's unpublished nodes are
+// added so that single threaded counts are exact at any time.
+uint64_t ThreadPool::nodes_searched() const {
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < nodeCounterCount; ++i)
+        sum += nodeCounters[i].nodes.load(std::memory_order_relaxed);
+
+    const Search::Worker& main      = *main_thread()->worker;
+    uint64_t              published = main.nodesPublished.load(std::memory_order_relaxed);
+    uint64_t              counted   = main.nodes.load(std::memory_order_relaxed);
+
+    return sum + (counted > published ? counted - published : 0);
+}
+
 uint64_t ThreadPool::tb_hits() const { return accumulate(&Search::Worker::tbHits); }
 
 // Creates/destroys threads to match the requested number.
@@ -139,7 +169,8 @@ uint64_t ThreadPool::tb_hits() const { return accumulate(&Search::Worker::tbHits
 // Upon resizing, threads are recreated to allow for binding if necessary.
 void ThreadPool::set(const NumaConfig&                           numaConfig,
                      Search::SharedState                         sharedState,
-                     const Search::SearchManager::UpdateContext& updateContext) {
+                     const Search::SearchManager::UpdateContext& updateContext,
+                     size_t                                      requested) {
 
     if (threads.size() > 0)  // destroy any existing thread(s)
     {
@@ -150,8 +181,6 @@ void ThreadPool::set(const NumaConfig&                           numaConfig,
         boundThreadToNumaNode.clear();
     }
 
-    const size_t requested = sharedState.options["Threads"];
-
     if (requested > 0)  // create new thread(s)
     {
         // Binding threads may be problematic when there's multiple NUMA nodes and
@@ -176,6 +205,11 @@ void ThreadPool::set(const NumaConfig&                           numaConfig,
                                 ? numaConfig.distribute_threads_among_numa_nodes(requested)
                                 : std::vector<NumaIndex>{};
 
+        // Nodes with no more threads than physical cores keep them off SMT siblings
+        std::vector<size_t> threadsOnNode(numaConfig.num_numa_nodes(), 0);
+        for (NumaIndex n : boundThreadToNumaNode)
+            threadsOnNode[n]++;
+
         while (threads.size() < requested)
         {
             const size_t    threadId = threads.size();
@@ -188,13 +222,30 @@ void ThreadPool::set(const NumaConfig&                           numaConfig,
             // from the same NUMA node, because in case of NUMA replicated memory
             // accesses we don't want to trash cache in case the threads get scheduled
             // on the same NUMA node.
-            auto binder = doBindThreads ? OptionalThreadToNumaNodeBinder(numaConfig, numaId)
-                                        : OptionalThreadToNumaNodeBinder(numaId);
+            auto binder =
+              doBindThreads
+                ? OptionalThreadToNumaNodeBinder(
+                    numaConfig, numaId,
+                    threadsOnNode[numaId] <= numaConfig.num_physical_cores_in_numa_node(numaId))
+                : OptionalThreadToNumaNodeBinder(numaId);
 
             threads.emplace_back(
               std::make_unique<Thread>(sharedState, std::move(manager), threadId, binder));
         }
 
+        nodeCounterCount =
+          doBindThreads ? *std::max_element(boundThreadToNumaNode.begin(),
+                                            boundThreadToNumaNode.end())
+                            + 1
+                        : 1;
+        nodeCounters = std::make_unique<Search::NodeCounter[]>(nodeCounterCount);
+
+        for (auto&& th : threads)
+            th->worker->nodeCounter =
+              &nodeCounters[th->worker->numaAccessToken.get_numa_index()];
+
+        set_spin_wait(int(sharedState.options["Wakeup Spin"]));
+
         clear();
 
         main_thread()->wait_for_search_finished();
@@ -221,6 +272,8 @@ void ThreadPool::clear() {
     main_manager()->bestPreviousScore  = VALUE_INFINITE;
     main_manager()->originalTimeAdjust = -1;
     main_manager()->tm.clear();
+    main_manager()->tbPvCache.clear();
+    main_manager()->treeReuse.clear();
 }
 
 void ThreadPool::run_on_thread(size_t threadId, std::function<void()> f) {
@@ -238,14 +291,15 @@ size_t ThreadPool::num_threads() const { return threads.size(); }
 
 // Wakes up main thread waiting in idle_loop() and returns immediately.
 // Main thread will wake up other threads and start the search.
-void ThreadPool::start_thinking(const OptionsMap&  options,
-                                Position&          pos,
-                                StateListPtr&      states,
-                                Search::LimitsType limits) {
+void ThreadPool::start_thinking(const Search::SearchConfig& config,
+                                Position&                   pos,
+                                StateListPtr&               states,
+                                Search::LimitsType          limits) {
 
     main_thread()->wait_for_search_finished();
 
     main_manager()->stopOnPonderhit = stop = abortedSearch = false;
+    main_manager()->stopTime                               = 0;
     main_manager()->ponder                                 = limits.ponderMode;
 
     increaseDepth = true;
@@ -265,7 +319,7 @@ void ThreadPool::start_thinking(const OptionsMap&  options,
         for (const auto& m : legalmoves)
             rootMoves.emplace_back(m);
 
-    Tablebases::Config tbConfig = Tablebases::rank_root_moves(options, pos, rootMoves);
+    Tablebases::Config tbConfig = Tablebases::rank_root_moves(config.syzygy, pos, rootMoves);
 
     // After ownership transfer 'states' becomes empty, so if we stop the search
     // and call 'go' again without setting a new position states.get() == nullptr.
@@ -279,17 +333,29 @@ void ThreadPool::start_thinking(const OptionsMap&  options,
     // be deduced from a fen string, so set() clears them and they are set from
     // setupStates->back() later. The rootState is per thread, earlier states are
     // shared since they are read-only.
+    for (size_t i = 0; i < nodeCounterCount; ++i)
+        nodeCounters[i].nodes = 0;
+
     for (auto&& th : threads)
     {
         th->run_custom_job([&]() {
             th->worker->limits = limits;
-            th->worker->nodes = th->worker->tbHits = th->worker->nmpMinPly =
-              th->worker->bestMoveChanges          = 0;
+            th->worker->nodes = th->worker->nodesPublished = th->worker->tbHits =
+              th->worker->nmpMinPly = th->worker->bestMoveChanges = 0;
+            th->worker->expInjected = th->worker->expReinjected = 0;
             th->worker->rootDepth = th->worker->completedDepth = 0;
             th->worker->rootMoves                              = rootMoves;
             th->worker->rootPos.set(pos.fen(), pos.is_chess960(), &th->worker->rootState);
             th->worker->rootState = setupStates->back();
             th->worker->tbConfig  = tbConfig;
+            th->worker->config    = config;
+
+            // Split go nodes in quotas, the first workers take the remainder
+            const size_t n = threads.size(), idx = th->worker->threadIdx;
+            th->worker->budgetReached = false;
+            th->worker->nodeBudget    = config.nodesPerThread && limits.nodes
+                                        ? limits.nodes / n + (idx < limits.nodes % n)
+                                        : Search::NoNodeBudget;
         });
     }
 
@@ -368,11 +434,59 @@ Thread* ThreadPool::get_best_thread() const {
 
 // Start non-main threads.
 // Will be invoked by main thread after it has started searching.
+// Wakes the helper threads through a binary tree rooted at the main thread:
+// every woken helper first wakes its own two children, so the last helper
+// starts after O(log n) wakeups instead of n sequential ones.
 void ThreadPool::start_searching() {
+    wake_children(0, [](Thread& th) { th.worker->start_searching(); });
+}
+
+void ThreadPool::wake_children(size_t parent, std::function<void(Thread&)> job) {
+
+    for (size_t child = 2 * parent + 1; child <= 2 * parent + 2 && child < threads.size(); ++child)
+        threads[child]->run_custom_job([this, child, job] {
+            wake_children(child, job);
+            job(*threads[child]);
+        });
+}
+
+void ThreadPool::set_spin_wait(int micros) {
 
     for (auto&& th : threads)
-        if (th != threads.front())
-            th->start_searching();
+        th->set_spin_wait(micros);
+}
+
+double ThreadPool::wakeup_latency(int rounds, bool fanOut) {
+
+    using Clock = std::chrono::steady_clock;
+
+    std::atomic<int64_t> last;
+    int64_t              total = 0;
+
+    auto stamp = [&last](Thread&) {
+        int64_t t    = Clock::now().time_since_epoch().count();
+        int64_t prev = last.load();
+        while (prev < t && !last.compare_exchange_weak(prev, t))
+        {}
+    };
+
+    for (int r = 0; r < rounds && threads.size() > 1; ++r)
+    {
+        int64_t start = Clock::now().time_since_epoch().count();
+        last          = start;
+
+        if (fanOut)
+            wake_children(0, stamp);
+        else
+            for (auto&& th : threads)
+                if (th != threads.front())
+                    th->run_custom_job([&stamp, &th] { stamp(*th); });
+
+        wait_for_search_finished();
+        total += last - start;
+    }
+
+    return double(std::chrono::nanoseconds(Clock::duration(total)).count()) / std::max(rounds, 1);
 }
 
 
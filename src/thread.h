@@ -50,13 +50,14 @@ class OptionalThreadToNumaNodeBinder {
         numaConfig(nullptr),
         numaId(n) {}
 
-    OptionalThreadToNumaNodeBinder(const NumaConfig& cfg, NumaIndex n) :
+    OptionalThreadToNumaNodeBinder(const NumaConfig& cfg, NumaIndex n, bool coresOnly = false) :
         numaConfig(&cfg),
-        numaId(n) {}
+        numaId(n),
+        physicalCoresOnly(coresOnly) {}
 
     NumaReplicatedAccessToken operator()() const {
         if (numaConfig != nullptr)
-            return numaConfig->bind_current_thread_to_numa_node(numaId);
+            return numaConfig->bind_current_thread_to_numa_node(numaId, physicalCoresOnly);
         else
             return NumaReplicatedAccessToken(numaId);
     }
@@ -64,6 +65,7 @@ class OptionalThreadToNumaNodeBinder {
    private:
     const NumaConfig* numaConfig;
     NumaIndex         numaId;
+    bool              physicalCoresOnly = false;
 };
 
 // Abstraction of a thread. It contains a pointer to the worker and a native thread.
@@ -86,6 +88,10 @@ class Thread {
 
     void ensure_network_replicated();
 
+    // Microseconds an idle thread keeps polling for a new job before it
+    // sleeps on the condition variable, 0 sleeps at once.
+    void set_spin_wait(int micros) { spinMicros = micros; }
+
     // Thread has been slightly altered to allow running custom jobs, so
     // this name is no longer correct. However, this class (and ThreadPool)
     // require further work to make them properly generic while maintaining
@@ -101,7 +107,9 @@ class Thread {
     std::mutex                mutex;
     std::condition_variable   cv;
     size_t                    idx, nthreads;
-    bool                      exit = false, searching = true;  // Set before starting std::thread
+    bool                      exit = false;       // Set before starting std::thread
+    std::atomic<bool>         searching{true};    // Polled without the lock while spinning
+    std::atomic<int>          spinMicros{0};
     NativeThread              stdThread;
     NumaReplicatedAccessToken numaAccessToken;
 };
@@ -130,14 +138,18 @@ class ThreadPool {
     ThreadPool& operator=(const ThreadPool&) = delete;
     ThreadPool& operator=(ThreadPool&&)      = delete;
 
-    void   start_thinking(const OptionsMap&, Position&, StateListPtr&, Search::LimitsType);
+    void   start_thinking(const Search::SearchConfig&,
+                          Position&,
+                          StateListPtr&,
+                          Search::LimitsType);
     void   run_on_thread(size_t threadId, std::function<void()> f);
     void   wait_on_thread(size_t threadId);
     size_t num_threads() const;
     void   clear();
     void   set(const NumaConfig& numaConfig,
                Search::SharedState,
-               const Search::SearchManager::UpdateContext&);
+               const Search::SearchManager::UpdateContext&,
+               size_t requested);
 
     Search::SearchManager* main_manager();
     Thread*                main_thread() const { return threads.front().get(); }
@@ -146,12 +158,18 @@ class ThreadPool {
     Thread*                get_best_thread() const;
     void                   start_searching();
     void                   wait_for_search_finished() const;
+    void                   set_spin_wait(int micros);
+
+    // Average nanoseconds from waking the helper threads until the last of
+    // them runs a job, waking them one by one or through the fan-out tree.
+    double wakeup_latency(int rounds, bool fanOut);
 
     std::vector<size_t> get_bound_thread_count_by_numa_node() const;
 
     void ensure_network_replicated();
 
     std::atomic_bool stop, abortedSearch, increaseDepth;
+    uint64_t         gamesStarted = 0;  // Counted by Engine::new_game(), seeds Variety
 
     auto cbegin() const noexcept { return threads.cbegin(); }
     auto begin() noexcept { return threads.begin(); }
@@ -161,10 +179,16 @@ class ThreadPool {
     auto empty() const noexcept { return threads.empty(); }
 
    private:
+    void wake_children(size_t parent, std::function<void(Thread&)> job);
+
     StateListPtr                         setupStates;
     std::vector<std::unique_ptr<Thread>> threads;
     std::vector<NumaIndex>               boundThreadToNumaNode;
 
+    // One published node count per NUMA node in use, see Search::NodeCounter
+    std::unique_ptr<Search::NodeCounter[]> nodeCounters;
+    size_t                                 nodeCounterCount = 0;
+
     uint64_t accumulate(std::atomic<uint64_t> Search::Worker::* member) const {
 
         uint64_t sum = 0;
@@ -24,7 +24,6 @@
 #include <cstdint>
 
 #include "search.h"
-#include "ucioption.h"
 
 namespace Hypnos {
 
@@ -40,16 +39,44 @@ void TimeManagement::advance_nodes_time(std::int64_t nodes) {
     availableNodes = std::max(int64_t(0), availableNodes - nodes);
 }
 
+// Folds the time from raising the stop signal to sending bestmove (thread
+// join, experience writes, final PV) into exponential moving averages of the
+// latency and of its absolute deviation.
+void TimeManagement::add_latency(TimePoint latency) {
+    constexpr double Alpha = 0.125;
+
+    if (latencySamples++ == 0)
+        latencyMean = double(latency);
+
+    latencyDev += Alpha * (std::abs(latency - latencyMean) - latencyDev);
+    latencyMean += Alpha * (latency - latencyMean);
+}
+
+// The Move Overhead option. With Adaptive Move Overhead and enough moves
+// measured, the latency mean plus four deviations on top of a margin for the
+// GUI side of the pipe when that is larger: Move Overhead stays the floor.
+TimePoint TimeManagement::move_overhead(const Search::SearchConfig& config) const {
+    constexpr int       MinSamples = 4;
+    constexpr TimePoint Margin     = 10;
+
+    if (!config.adaptiveMoveOverhead || latencySamples < MinSamples)
+        return TimePoint(config.moveOverhead);
+
+    const TimePoint measured = Margin + TimePoint(std::ceil(latencyMean + 4 * latencyDev));
+
+    return std::max(TimePoint(config.moveOverhead), std::min(TimePoint(5000), measured));
+}
+
 // Called at the beginning of the search and calculates
 // the bounds of time allowed for the current game ply. We currently support:
 //      1) x basetime (+ z increment)
 //      2) x moves in y seconds (+ z increment)
-void TimeManagement::init(Search::LimitsType& limits,
-                          Color               us,
-                          int                 ply,
-                          const OptionsMap&   options,
-                          double&             originalTimeAdjust) {
-    TimePoint npmsec = TimePoint(options["nodestime"]);
+void TimeManagement::init(Search::LimitsType&         limits,
+                          Color                       us,
+                          int                         ply,
+                          const Search::SearchConfig& config,
+                          double&                     originalTimeAdjust) {
+    TimePoint npmsec = TimePoint(config.nodestime);
 
     // If we have no time, we don't need to fully initialize TM.
     // startTime is used by movetime and useNodesTime is used in elapsed calls.
@@ -59,11 +86,11 @@ void TimeManagement::init(Search::LimitsType& limits,
     if (limits.time[us] == 0)
         return;
 
-    TimePoint moveOverhead = TimePoint(options["Move Overhead"]);
+    TimePoint moveOverhead = move_overhead(config);
 
     // Extra UCI knobs
-    TimePoint minThinkingTime = TimePoint(options["Minimum Thinking Time"]); // ms
-    int       slowMoverPct    = int(options["Slow Mover"]);                  // percent (100 = no change)
+    TimePoint minThinkingTime = TimePoint(config.minimumThinkingTime);  // ms
+    int       slowMoverPct    = config.slowMover;  // percent (100 = no change)
 
     // optScale is a percentage of available time to use for the current move.
     // maxScale is a multiplier applied to optimumTime.
@@ -154,7 +181,7 @@ void TimeManagement::init(Search::LimitsType& limits,
     maximumTime = std::max(maximumTime, optimumTime);
 
     // Ponder bonus: boost both to preserve max >= opt
-    if (options["Ponder"]) {
+    if (config.ponder) {
         optimumTime += optimumTime / 4;   // +25%
         maximumTime += maximumTime / 4;
     }
@@ -25,22 +25,22 @@
 
 namespace Hypnos {
 
-class OptionsMap;
 enum Color : int8_t;
 
 namespace Search {
 struct LimitsType;
+struct SearchConfig;
 }
 
 // The TimeManagement class computes the optimal time to think depending on
 // the maximum available time, the game move number, and other parameters.
 class TimeManagement {
    public:
-    void init(Search::LimitsType& limits,
-              Color               us,
-              int                 ply,
-              const OptionsMap&   options,
-              double&             originalTimeAdjust);
+    void init(Search::LimitsType&         limits,
+              Color                       us,
+              int                         ply,
+              const Search::SearchConfig& config,
+              double&                     originalTimeAdjust);
 
     TimePoint optimum() const;
     TimePoint maximum() const;
@@ -53,6 +53,10 @@ class TimeManagement {
     void clear();
     void advance_nodes_time(std::int64_t nodes);
 
+    // Self-measured stop to bestmove latency, see 'Adaptive Move Overhead'
+    void      add_latency(TimePoint latency);
+    TimePoint move_overhead(const Search::SearchConfig& config) const;
+
    private:
     TimePoint startTime;
     TimePoint optimumTime;
@@ -60,6 +64,9 @@ class TimeManagement {
 
     std::int64_t availableNodes = -1;     // When in 'nodes as time' mode
     bool         useNodesTime   = false;  // True if we are in 'nodes as time' mode
+
+    double latencyMean = 0, latencyDev = 0;  // Moving averages, in ms
+    int    latencySamples = 0;
 };
 
 }  // namespace Hypnos
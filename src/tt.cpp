@@ -62,6 +62,7 @@ struct TTEntry {
 
    private:
     friend class TranspositionTable;
+    friend struct TTWriter;
 
     uint16_t key16;
     uint8_t  depth8;
@@ -125,28 +126,64 @@ uint8_t TTEntry::relative_age(const uint8_t generation8) const {
 }
 
 
+// A TranspositionTable is an array of Cluster, of size clusterCount. Each cluster consists of ClusterSize number
+// of TTEntry. Each non-empty TTEntry contains information on exactly one position. The size of a Cluster should
+// divide the size of a cache line for best performance, as the cacheline is prefetched when possible.
+//
+// An entry written from the experience file is pinned in its cluster: it is never picked for replacement, and
+// only results at least as deep for the same position overwrite it, so the search does not materialize it again
+// after every eviction. At most one entry per cluster is pinned, a newer pin replaces the older one. A pin lapses
+// once its entry is PIN_MAX_AGE searches old, so positions the game has left behind free their slot.
+
+static constexpr int ClusterSize = 3;
+
+struct Cluster {
+    TTEntry entry[ClusterSize];
+    uint8_t pinned;      // One bit per entry holding experience data
+    char    padding[1];  // Pad to 32 bytes
+};
+
+static_assert(sizeof(Cluster) == 32, "Suboptimal Cluster size");
+
+static constexpr int PIN_MAX_AGE = 2 * GENERATION_DELTA;
+
+static bool is_pinned(const Cluster* cl, const TTEntry* tte, uint8_t generation8) {
+    return (cl->pinned >> (tte - cl->entry) & 1) && tte->relative_age(generation8) <= PIN_MAX_AGE;
+}
+
+// The table is page aligned, so the cluster of an entry is found by masking its address
+static Cluster* cluster_of(TTEntry* tte) {
+    return reinterpret_cast<Cluster*>(uintptr_t(tte) & ~uintptr_t(sizeof(Cluster) - 1));
+}
+
+
 // TTWriter is but a very thin wrapper around the pointer
 TTWriter::TTWriter(TTEntry* tte) :
     entry(tte) {}
 
 void TTWriter::write(
   Key k, Value v, bool pv, Bound b, Depth d, Move m, Value ev, uint8_t generation8) {
+
+    Cluster* const cl = cluster_of(entry);
+
+    if (is_pinned(cl, entry, generation8)
+        && (uint16_t(k) != entry->key16 || d - DEPTH_ENTRY_OFFSET < entry->depth8))
+        return;
+
     entry->save(k, v, pv, b, d, m, ev, generation8);
 }
 
+bool TTWriter::write_experience(Key k, Value v, Bound b, Depth d, Move m, uint8_t generation8) {
 
-// A TranspositionTable is an array of Cluster, of size clusterCount. Each cluster consists of ClusterSize number
-// of TTEntry. Each non-empty TTEntry contains information on exactly one position. The size of a Cluster should
-// divide the size of a cache line for best performance, as the cacheline is prefetched when possible.
+    Cluster* const cl  = cluster_of(entry);
+    const uint8_t  bit = uint8_t(1 << (entry - cl->entry));
+    const bool     was = is_pinned(cl, entry, generation8) && uint16_t(k) == entry->key16;
 
-static constexpr int ClusterSize = 3;
+    entry->save(k, v, true, b, d, m, VALUE_NONE, generation8);
+    cl->pinned = bit;
 
-struct Cluster {
-    TTEntry entry[ClusterSize];
-    char    padding[2];  // Pad to 32 bytes
-};
-
-static_assert(sizeof(Cluster) == 32, "Suboptimal Cluster size");
+    return was;
+}
 
 
 // Sets the size of the transposition table,
@@ -207,6 +244,16 @@ int TranspositionTable::hashfull(int maxAge) const {
 }
 
 
+int TranspositionTable::pinnedfull() const {
+    int cnt = 0;
+    for (int i = 0; i < 1000; ++i)
+        for (int j = 0; j < ClusterSize; ++j)
+            cnt += is_pinned(&table[i], &table[i].entry[j], generation8);
+
+    return cnt;
+}
+
+
 void TranspositionTable::new_search() {
     // increment by delta to keep lower bits as is
     generation8 += GENERATION_DELTA;
@@ -233,11 +280,14 @@ std::tuple<bool, TTData, TTWriter> TranspositionTable::probe(const Key key) cons
             // After `read()` completes that copy is final, but may be self-inconsistent.
             return {tte[i].is_occupied(), tte[i].read(), TTWriter(&tte[i])};
 
-    // Find an entry to be replaced according to the replacement strategy
-    TTEntry* replace = tte;
+    // Find an entry to be replaced according to the replacement strategy,
+    // pinned entries are skipped
+    const Cluster* cl      = cluster_of(tte);
+    TTEntry*       replace = is_pinned(cl, tte, generation8) ? tte + 1 : tte;
     for (int i = 1; i < ClusterSize; ++i)
-        if (replace->depth8 - replace->relative_age(generation8)
-            > tte[i].depth8 - tte[i].relative_age(generation8))
+        if (!is_pinned(cl, &tte[i], generation8)
+            && replace->depth8 - replace->relative_age(generation8)
+                 > tte[i].depth8 - tte[i].relative_age(generation8))
             replace = &tte[i];
 
     return {false,
@@ -70,6 +70,9 @@ struct TTData {
 struct TTWriter {
    public:
     void write(Key k, Value v, bool pv, Bound b, Depth d, Move m, Value ev, uint8_t generation8);
+    // Stores data taken from the experience file and pins the entry, returns
+    // true if the entry was already pinned for this position.
+    bool write_experience(Key k, Value v, Bound b, Depth d, Move m, uint8_t generation8);
 
    private:
     friend class TranspositionTable;
@@ -87,6 +90,7 @@ class TranspositionTable {
     void clear(ThreadPool& threads);                  // Re-initialize memory, multithreaded
     int  hashfull(int maxAge = 0)
       const;  // Approximate what fraction of entries (permille) have been written to during this root search
+    int pinnedfull() const;  // Approximate what fraction of clusters (permille) hold a pinned entry
 
     void
     new_search();  // This must be called at the beginning of each root search to track entry aging
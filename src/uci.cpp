@@ -21,7 +21,9 @@
 #include <algorithm>
 #include <cctype>
 #include <cmath>
+#include <cstdio>
 #include <cstdint>
+#include <fstream>
 #include <iterator>
 #include <optional>
 #include <sstream>
@@ -30,10 +32,12 @@
 #include <vector>
 
 #include "benchmark.h"
+#include "bookbuilder.h"
 #include "engine.h"
 #include "experience.h"
 #include "memory.h"
 #include "movegen.h"
+#include "perfcounters.h"
 #include "position.h"
 #include "score.h"
 #include "search.h"
@@ -117,13 +121,13 @@ struct overload: Ts... {
 template<typename... Ts>
 overload(Ts...) -> overload<Ts...>;
 
-void UCIEngine::print_info_string(std::string_view str) {
+void UCIEngine::print_info_string(std::string_view str, std::string_view prefix) {
     sync_cout_start();
     for (auto& line : split(str, "\n"))
     {
         if (!is_whitespace(line))
         {
-            std::cout << "info string " << line << '\n';
+            std::cout << prefix << "info string " << line << '\n';
         }
     }
     sync_cout_end();
@@ -153,6 +157,7 @@ void UCIEngine::init_search_update_listeners() {
       [this](const auto& i) { on_update_full(i); });
     engine.set_on_bestmove([](const auto& bm, const auto& p) { on_bestmove(bm, p); });
     engine.set_on_verify_networks([](const auto& s) { print_info_string(s); });
+    engine.set_on_info_string([](const auto& s) { print_info_string(s); });
 }
 
 void UCIEngine::loop() {
@@ -174,6 +179,10 @@ void UCIEngine::loop() {
 
         if (token == "quit" || token == "stop") {
             engine.stop();
+
+            if (token == "quit")
+                for (auto& [id, s] : sessions)
+                    s->stop();
         }
         else if (token == "ponderhit") {
             // The GUI played the expected move: disable ponder
@@ -196,7 +205,8 @@ void UCIEngine::loop() {
             const std::string firstFEN = engine.fen();
 #if defined(HYP_FIXED_ZOBRIST)
             ensure_exp_initialized(engine);
-            if (firstFEN == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")
+            if (firstFEN == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+                && sessions.empty())
                 Experience::resume_learning();
 #endif
             print_info_string(engine.numa_config_information_as_string());
@@ -211,9 +221,10 @@ void UCIEngine::loop() {
             ensure_exp_initialized(engine);
             Experience::save();
 #endif
-            engine.search_clear();
+            engine.new_game();
 #if defined(HYP_FIXED_ZOBRIST)
-            Experience::resume_learning();
+            if (sessions.empty())
+                Experience::resume_learning();
 #endif
         }
         else if (token == "isready") {
@@ -229,6 +240,26 @@ void UCIEngine::loop() {
         else if (token == BenchmarkCommand) {
             benchmark(is);
         }
+        else if (token == "analyze") {
+            analyze(is);
+        }
+        else if (token == "pack") {
+            pack(is);
+        }
+        else if (token == "wakebench") {
+            // Syntax: wakebench [max threads] [rounds]
+            size_t maxThreads = get_hardware_concurrency();
+            int    rounds     = 1000;
+            is >> maxThreads >> rounds;
+
+            std::istringstream report(
+              engine.wakeup_benchmark(std::max(maxThreads, size_t(2)), std::max(rounds, 1)));
+            for (std::string line; std::getline(report, line);)
+                print_info_string(line);
+        }
+        else if (token == "session") {
+            session(is);
+        }
         else if (token == "d") {
             sync_cout << engine.visualize() << sync_endl;
         }
@@ -388,8 +419,25 @@ void UCIEngine::loop() {
                 Experience::pgn_to_exp((int)cargs.size(), cargs.data());
             }
         }
+        else if (token == "exp_to_book")
+            exp_to_book(is);
 #endif
 
+        else if (token == "pgn_to_book")
+        {
+            // Syntax: pgn_to_book <source.pgn> <dest.bin> [max ply]
+            std::string pgn, book;
+            int         maxPly = 40;
+
+            if (!(is >> pgn >> book))
+                print_info_string("Syntax: pgn_to_book <source.pgn> <dest.bin> [max ply]");
+            else
+            {
+                is >> maxPly;
+                BookBuilder::pgn_to_book(pgn, book, std::max(maxPly, 0),
+                                         size_t(engine.get_options()["Threads"]));
+            }
+        }
         else if (token == "legal") {
             // Print every LEGAL move in the current engine position.
             // Format: "legal <m1> <m2> ..."
@@ -467,6 +515,8 @@ Search::LimitsType UCIEngine::parse_limits(std::istream& is) {
             is >> limits.mate;
         else if (token == "perft")
             is >> limits.perft;
+        else if (token == "stats")
+            limits.perftStats = true;
         else if (token == "infinite")
             limits.infinite = 1;
         else if (token == "ponder")
@@ -485,12 +535,32 @@ void UCIEngine::go(std::istringstream& is) {
         engine.go(limits);
 }
 
-void UCIEngine::bench(std::istream& args) {
+void UCIEngine::exp_to_book(std::istream& is) {
 #if defined(HYP_FIXED_ZOBRIST)
-    // Bench mode ON: create .exp header only, suppress entry writes
-    Experience::g_benchMode.store(true, std::memory_order_relaxed);
-    Experience::touch();
+    ensure_exp_initialized(engine);
+    Experience::wait_for_loading_finished();
+
+    // Syntax: exp_to_book <dest.bin> [max ply] [min depth]
+    const auto& opts = engine.get_options();
+    std::string book;
+    int         maxPly   = 2 * int(opts["Experience Book Max Moves"]);
+    int         minDepth = int(opts["Experience Book Min Depth"]);
+
+    if (!(is >> book))
+        print_info_string("Syntax: exp_to_book <dest.bin> [max ply] [min depth]");
+    else
+    {
+        is >> maxPly >> minDepth;
+        BookBuilder::exp_to_book(book, maxPly, minDepth,
+                                 int(opts["Experience Book Eval Importance"]),
+                                 size_t(opts["Threads"]));
+    }
+#else
+    (void) is;
 #endif
+}
+
+void UCIEngine::bench(std::istream& args) {
     std::string token;
     uint64_t    num, nodes = 0, cnt = 1;
     uint64_t    nodesSearched = 0;
@@ -500,12 +570,35 @@ void UCIEngine::bench(std::istream& args) {
         on_update_full(i);
     });
 
-    std::vector<std::string> list = Benchmark::setup_bench(engine.fen(), args);
+    Benchmark::BenchSetup     setup = Benchmark::setup_bench(engine.fen(), engine.get_options(), args);
+    std::vector<std::string>& list  = setup.commands;
+
+    for (const auto& file : setup.scratchFiles)
+        std::remove(file.c_str());
+
+#if defined(HYP_FIXED_ZOBRIST)
+    // Bench mode ON: create .exp header only, suppress entry writes unless
+    // a profile has switched to one of its scratch experience files.
+    const auto set_bench_mode = [&] {
+        const std::string expFile = engine.get_options()["Experience File"];
+        const auto&       scratch = setup.scratchFiles;
+        Experience::g_benchMode.store(std::find(scratch.begin(), scratch.end(), expFile)
+                                        == scratch.end(),
+                                      std::memory_order_relaxed);
+    };
+    set_bench_mode();
+    Experience::touch();
+#endif
+
+    // Read per position, bench commands may change the number of threads
+    const bool           perfCounters = bool(engine.get_options()["Perf Counters"]);
+    PerfCounters::Totals perfTotals;
 
     num = count_if(list.begin(), list.end(),
                    [](const std::string& s) { return s.find("go ") == 0 || s.find("eval") == 0; });
 
-    TimePoint elapsed = now();
+    // Time spent in setoption and ucinewgame is not counted
+    TimePoint elapsed = 0, start = now();
 
     for (const auto& cmd : list)
     {
@@ -524,8 +617,14 @@ void UCIEngine::bench(std::istream& args) {
                     nodesSearched = perft(limits);
                 else
                 {
+                    if (perfCounters)
+                        engine.start_perf_counters();
+
                     engine.go(limits);
                     engine.wait_for_search_finished();
+
+                    if (perfCounters)
+                        perfTotals += engine.stop_perf_counters();
                 }
 
                 nodes += nodesSearched;
@@ -535,24 +634,49 @@ void UCIEngine::bench(std::istream& args) {
                 engine.trace_eval();
         }
         else if (token == "setoption")
+        {
+            elapsed += now() - start;
             setoption(is);
+#if defined(HYP_FIXED_ZOBRIST)
+            set_bench_mode();
+#endif
+            start = now();
+        }
         else if (token == "position")
-            position(is);
+        {
+            // Records of packed position files are set up without a FEN round trip
+            size_t index;
+            if (cmd.compare(0, 16, "position packed ") == 0 && is >> token >> index)
+                engine.set_position(setup.packed[index]);
+            else
+                position(is);
+        }
         else if (token == "ucinewgame")
         {
-            engine.search_clear();  // search_clear may take a while
-            elapsed = now();
+            elapsed += now() - start;
+            engine.new_game();  // new_game may take a while
+            start = now();
         }
+        else if (token == "exp_to_book")
+            exp_to_book(is);
     }
 
-    elapsed = now() - elapsed + 1;  // Ensure positivity to avoid a 'divide by zero'
+    elapsed += now() - start + 1;  // Ensure positivity to avoid a 'divide by zero'
+
+    for (const auto& file : setup.scratchFiles)
+        std::remove(file.c_str());
 
     dbg_print();
 
     std::cerr << "\n==========================="    //
               << "\nTotal time (ms) : " << elapsed  //
               << "\nNodes searched  : " << nodes    //
-              << "\nNodes/second    : " << 1000 * nodes / elapsed << std::endl;
+              << "\nNodes/second    : " << 1000 * nodes / elapsed;
+
+    if (perfCounters)
+        std::cerr << perf_counters_report(perfTotals, nodes);
+
+    std::cerr << std::endl;
 
 #if defined(HYP_FIXED_ZOBRIST)
     // Bench mode OFF
@@ -626,7 +750,7 @@ void UCIEngine::benchmark(std::istream& args) {
             position(is);
         else if (token == "ucinewgame")
         {
-            engine.search_clear();  // search_clear may take a while
+            engine.new_game();  // new_game may take a while
         }
 
         if (cnt > NUM_WARMUP_POSITIONS)
@@ -654,6 +778,9 @@ void UCIEngine::benchmark(std::istream& args) {
         }
     };
 
+    const bool           perfCounters = bool(engine.get_options()["Perf Counters"]);
+    PerfCounters::Totals perfTotals;
+
     engine.search_clear();  // search_clear may take a while
 
     for (const auto& cmd : setup.commands)
@@ -668,6 +795,9 @@ void UCIEngine::benchmark(std::istream& args) {
 
             Search::LimitsType limits = parse_limits(is);
 
+            if (perfCounters)
+                engine.start_perf_counters();
+
             TimePoint elapsed = now();
 
             // Run with silenced network verification
@@ -676,6 +806,9 @@ void UCIEngine::benchmark(std::istream& args) {
 
             totalTime += now() - elapsed;
 
+            if (perfCounters)
+                perfTotals += engine.stop_perf_counters();
+
             updateHashfullReadings();
 
             nodes += nodesSearched;
@@ -685,7 +818,7 @@ void UCIEngine::benchmark(std::istream& args) {
             position(is);
         else if (token == "ucinewgame")
         {
-            engine.search_clear();  // search_clear may take a while
+            engine.new_game();  // new_game may take a while
         }
     }
 
@@ -725,7 +858,12 @@ void UCIEngine::benchmark(std::istream& args) {
               << totalHashfull[1] / numHashfullReadings
               << "\nTotal nodes searched       : " << nodes
               << "\nTotal search time [s]      : " << totalTime / 1000.0
-              << "\nNodes/second               : " << 1000 * nodes / totalTime << std::endl;
+              << "\nNodes/second               : " << 1000 * nodes / totalTime;
+
+    if (perfCounters)
+        std::cerr << perf_counters_report(perfTotals, nodes);
+
+    std::cerr << std::endl;
 
     // clang-format on
 
@@ -743,18 +881,290 @@ void UCIEngine::benchmark(std::istream& args) {
 #endif
 }
 
+// Syntax: analyze <file.epd> <threads-per-job> <limit>
+// where <limit> uses the 'go' syntax, e.g. 'depth 20', 'nodes 1000000' or 'movetime 500'.
+void UCIEngine::analyze(std::istream& args) {
+    std::string epdFile;
+    size_t      threadsPerJob = 0;
+
+    if (!(args >> epdFile >> threadsPerJob) || !threadsPerJob)
+    {
+        print_info_string("Syntax: analyze <file.epd> <threads-per-job> <limit>");
+        return;
+    }
+
+    Search::LimitsType limits = parse_limits(args);
+
+    if (limits.perft || limits.infinite || limits.ponderMode || limits.use_time_management()
+        || !(limits.depth || limits.nodes || limits.movetime || limits.mate))
+    {
+        print_info_string("analyze needs a depth, nodes, movetime or mate limit");
+        return;
+    }
+
+    Benchmark::PositionList positions;
+    if (!Benchmark::read_positions(epdFile, positions))
+    {
+        print_info_string("Unable to read position file " + epdFile);
+        return;
+    }
+
+    TimePoint elapsed = now();
+
+    const bool chess960 = engine.get_options()["UCI_Chess960"];
+
+    engine.analyze(positions, threadsPerJob, limits,
+                   [&](size_t job, const Engine::InfoFull& info, std::string_view bestmove) {
+                       std::stringstream ss;
+
+                       ss << "analysis " << job + 1 << " fen " << positions.fen(job, chess960)  //
+                          << " depth " << info.depth                                            //
+                          << " score " << format_score(info.score);                             //
+
+                       if (!info.bound.empty())
+                           ss << " " << info.bound;
+
+                       ss << " nodes " << info.nodes     //
+                          << " time " << info.timeMs     //
+                          << " bestmove " << bestmove    //
+                          << " pv " << info.pv;          //
+
+                       sync_cout << ss.str() << sync_endl;
+                   });
+
+    elapsed = now() - elapsed + 1;
+
+    print_info_string("analyze: " + std::to_string(positions.size()) + " positions in "
+                      + std::to_string(elapsed) + " ms");
+}
+
+// Syntax: pack <positions file> [<out.bin>]
+// Converts a FEN/EPD file to packed binary positions and reports the FEN versus
+// packed encode/decode throughput on its positions.
+void UCIEngine::pack(std::istream& args) {
+    std::string in, out;
+
+    if (!(args >> in))
+    {
+        print_info_string("Syntax: pack <positions file> [<out.bin>]");
+        return;
+    }
+
+    const bool              chess960 = engine.get_options()["UCI_Chess960"];
+    Benchmark::PositionList positions;
+
+    if (!Benchmark::read_positions(in, positions))
+    {
+        print_info_string("Unable to read position file " + in);
+        return;
+    }
+
+    if (args >> out)
+    {
+        if (!Benchmark::write_packed_positions(out, positions, chess960))
+        {
+            print_info_string("Unable to write " + out);
+            return;
+        }
+        print_info_string("Packed " + std::to_string(positions.size()) + " positions to " + out);
+    }
+
+    // The speedtest measures FEN parsing too, so packed input is decoded here
+    std::vector<std::string> fens = positions.fens;
+    for (size_t i = fens.size(); i < positions.size(); ++i)
+        fens.push_back(positions.fen(i, chess960));
+
+    std::istringstream report(Benchmark::position_format_speedtest(fens, chess960));
+    for (std::string line; std::getline(report, line);)
+        print_info_string(line);
+}
+
+namespace {
+
+// Reads the option name of a 'setoption name <id> value <x>' command
+bool is_shared_option(std::istringstream is) {
+    std::string token, name;
+
+    is >> token;  // Consume the "name" token
+    while (is >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+
+    return Engine::is_shared_option(name);
+}
+
+}
+
 void UCIEngine::setoption(std::istringstream& is) {
     engine.wait_for_search_finished();
+
+    // Shared state is swapped only while no session is searching, and sessions
+    // drop their caches in case the networks changed.
+    const bool shared = !sessions.empty() && is_shared_option(std::istringstream(is.str()));
+    if (shared)
+        for (auto& [id, s] : sessions)
+            s->wait_for_search_finished();
+
     engine.get_options().setoption(is);
+
+    if (shared)
+        for (auto& [id, s] : sessions)
+            s->search_clear();
+}
+
+// Syntax: session <id> <command>
+// Runs a UCI command on the logical engine <id>, created on first use, and
+// prefixes everything it prints with 'session <id>'. Sessions keep their own
+// options, TT and threads; networks, books, tablebases and experience (read
+// only) are shared with the main engine. 'session <id> quit' closes it.
+void UCIEngine::session(std::istringstream& is) {
+    std::string id, token;
+
+    if (!(is >> id >> token))
+    {
+        print_info_string("Syntax: session <id> <command>");
+        return;
+    }
+
+    const std::string prefix = "session " + id + " ";
+    auto              it     = sessions.find(id);
+
+    if (token == "quit")
+    {
+        if (it == sessions.end())
+            return;
+
+        it->second->stop();
+        sessions.erase(it);
+
+#if defined(HYP_FIXED_ZOBRIST)
+        // Only undo the pause taken for the sessions, not one set before them
+        if (sessions.empty() && !learningPausedBeforeSessions)
+            Experience::resume_learning();
+#endif
+        return;
+    }
+
+    if (it == sessions.end())
+    {
+#if defined(HYP_FIXED_ZOBRIST)
+        // The main engine must not grow the experience tables while sessions probe them
+        if (sessions.empty())
+            learningPausedBeforeSessions = Experience::is_learning_paused();
+        Experience::pause_learning();
+#endif
+        it = sessions.emplace(id, std::make_unique<Engine>(engine)).first;
+
+        Engine& s = *it->second;
+        s.get_options().add_info_listener([prefix](const std::optional<std::string>& str) {
+            if (str.has_value())
+                print_info_string(*str, prefix);
+        });
+        s.set_on_iter([prefix](const auto& i) { on_iter(i, prefix); });
+        s.set_on_update_no_moves([prefix](const auto& i) { on_update_no_moves(i, prefix); });
+        s.set_on_update_full([prefix](const auto& i) { on_update_full(i, prefix); });
+        s.set_on_bestmove([prefix](const auto& bm, const auto& p) {
+            sync_cout << prefix << "bestmove " << bm;
+            if (!p.empty())
+                std::cout << " ponder " << p;
+            std::cout << sync_endl;
+        });
+        s.set_on_verify_networks([prefix](const auto& str) { print_info_string(str, prefix); });
+        s.set_on_info_string([prefix](const auto& str) { print_info_string(str, prefix); });
+    }
+
+    Engine& s = *it->second;
+
+    if (token == "stop")
+        s.stop();
+    else if (token == "ponderhit")
+        s.set_ponderhit(false);
+    else if (token == "uci")
+    {
+        std::stringstream ss;
+        ss << "id name " << engine_info(true) << "\n" << s.get_options() << "\nuciok";
+
+        sync_cout_start();
+        for (auto& line : split(ss.str(), "\n"))
+            if (!is_whitespace(line))
+                std::cout << prefix << line << '\n';
+        sync_cout_end();
+    }
+    else if (token == "setoption")
+    {
+        std::string args;
+        std::getline(is, args);
+
+        if (is_shared_option(std::istringstream(args)))
+            print_info_string("this option is shared by all sessions, set it without 'session'",
+                              prefix);
+        else
+        {
+            std::istringstream argStream(args);
+            s.wait_for_search_finished();
+            s.get_options().setoption(argStream);
+        }
+    }
+    else if (token == "go")
+    {
+        Search::LimitsType limits = parse_limits(is);
+
+        if (limits.perft)
+            sync_cout << prefix << "info string nodes "
+                      << s.perft(s.fen(), limits.perft, s.get_options()["UCI_Chess960"])
+                      << sync_endl;
+        else
+            s.go(limits);
+    }
+    else if (token == "position")
+        position(s, is);
+    else if (token == "ucinewgame")
+        s.new_game();
+    else if (token == "isready")
+        sync_cout << prefix << "readyok" << sync_endl;
+    else if (token == "d")
+    {
+        sync_cout_start();
+        for (auto& line : split(s.visualize(), "\n"))
+            std::cout << prefix << line << '\n';
+        sync_cout_end();
+    }
+    else
+        print_info_string("Unknown session command: '" + token + "'", prefix);
 }
 
 std::uint64_t UCIEngine::perft(const Search::LimitsType& limits) {
-    auto nodes = engine.perft(engine.fen(), limits.perft, engine.get_options()["UCI_Chess960"]);
-    sync_cout << "\nNodes searched: " << nodes << "\n" << sync_endl;
+    const bool chess960 = engine.get_options()["UCI_Chess960"];
+
+    if (limits.perftStats)
+    {
+        TimePoint elapsed = now();
+        auto      stats   = engine.perft_stats(engine.fen(), limits.perft, chess960);
+        elapsed           = now() - elapsed + 1;
+
+        sync_cout << "\nNodes searched: " << stats.nodes                      //
+                  << "\nNodes/second: " << 1000 * stats.nodes / elapsed       //
+                  << "\nCaptures: " << stats.captures                         //
+                  << "\nEn passant: " << stats.enPassants                     //
+                  << "\nCastles: " << stats.castles                           //
+                  << "\nPromotions: " << stats.promotions                     //
+                  << "\nChecks: " << stats.checks                             //
+                  << "\nCheckmates: " << stats.mates << "\n"                  //
+                  << sync_endl;
+        return stats.nodes;
+    }
+
+    TimePoint elapsed = now();
+    auto      nodes   = engine.perft(engine.fen(), limits.perft, chess960);
+    elapsed           = now() - elapsed + 1;  // Ensure positivity to avoid a 'divide by zero'
+
+    sync_cout << "\nNodes searched: " << nodes << "\nNodes/second: " << 1000 * nodes / elapsed
+              << "\n" << sync_endl;
     return nodes;
 }
 
-void UCIEngine::position(std::istringstream& is) {
+void UCIEngine::position(std::istringstream& is) { position(engine, is); }
+
+void UCIEngine::position(Engine& target, std::istringstream& is) {
     std::string token, fen;
 
     is >> token;
@@ -777,7 +1187,7 @@ void UCIEngine::position(std::istringstream& is) {
         moves.push_back(token);
     }
 
-    engine.set_position(fen, moves);
+    target.set_position(fen, moves);
 }
 
 namespace { // anonymous helpers only for win_rate_model
@@ -880,14 +1290,15 @@ Move UCIEngine::to_move(const Position& pos, std::string str) {
     return Move::none();
 }
 
-void UCIEngine::on_update_no_moves(const Engine::InfoShort& info) {
-    sync_cout << "info depth " << info.depth << " score " << format_score(info.score) << sync_endl;
+void UCIEngine::on_update_no_moves(const Engine::InfoShort& info, std::string_view prefix) {
+    sync_cout << prefix << "info depth " << info.depth << " score " << format_score(info.score)
+              << sync_endl;
 }
 
-void UCIEngine::on_update_full(const Engine::InfoFull& info) {
+void UCIEngine::on_update_full(const Engine::InfoFull& info, std::string_view prefix) {
     std::stringstream ss;
 
-    ss << "info";
+    ss << prefix << "info";
     ss << " depth " << info.depth                 //
        << " seldepth " << info.selDepth           //
        << " multipv " << info.multiPV             //
@@ -906,10 +1317,10 @@ void UCIEngine::on_update_full(const Engine::InfoFull& info) {
     sync_cout << ss.str() << sync_endl;
 }
 
-void UCIEngine::on_iter(const Engine::InfoIter& info) {
+void UCIEngine::on_iter(const Engine::InfoIter& info, std::string_view prefix) {
     std::stringstream ss;
 
-    ss << "info";
+    ss << prefix << "info";
     ss << " depth " << info.depth                     //
        << " currmove " << info.currmove               //
        << " currmovenumber " << info.currmovenumber;  //
@@ -21,6 +21,8 @@
 
 #include <cstdint>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 
@@ -58,18 +60,27 @@ class UCIEngine {
     Engine      engine;
     CommandLine cli;
 
-    static void print_info_string(std::string_view str);
+    // Logical engines multiplexed over stdin by the 'session' command
+    std::map<std::string, std::unique_ptr<Engine>> sessions;
+    bool                                           learningPausedBeforeSessions = false;
+
+    static void print_info_string(std::string_view str, std::string_view prefix = {});
 
     void          go(std::istringstream& is);
     void          bench(std::istream& args);
+    void          exp_to_book(std::istream& is);
     void          benchmark(std::istream& args);
+    void          analyze(std::istream& args);
+    void          pack(std::istream& args);
     void          position(std::istringstream& is);
+    static void   position(Engine& target, std::istringstream& is);
+    void          session(std::istringstream& is);
     void          setoption(std::istringstream& is);
     std::uint64_t perft(const Search::LimitsType&);
 
-    static void on_update_no_moves(const Engine::InfoShort& info);
-    static void on_update_full(const Engine::InfoFull& info);
-    static void on_iter(const Engine::InfoIter& info);
+    static void on_update_no_moves(const Engine::InfoShort& info, std::string_view prefix = {});
+    static void on_update_full(const Engine::InfoFull& info, std::string_view prefix = {});
+    static void on_iter(const Engine::InfoIter& info, std::string_view prefix = {});
     static void on_bestmove(std::string_view bestmove, std::string_view ponder);
 
     void init_search_update_listeners();
@@ -23,6 +23,7 @@
 #include <cctype>
 #include <cstdlib>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <utility>
 
@@ -39,6 +40,8 @@ bool CaseInsensitiveLess::operator()(const std::string& s1, const std::string& s
 
 void OptionsMap::add_info_listener(InfoListener&& message_func) { info = std::move(message_func); }
 
+void OptionsMap::add_change_listener(ChangeListener&& listener) { changed = std::move(listener); }
+
 void OptionsMap::setoption(std::istringstream& is) {
     std::string token, name, value;
 
@@ -53,7 +56,12 @@ void OptionsMap::setoption(std::istringstream& is) {
         value += (value.empty() ? "" : " ") + token;
 
     if (options_map.count(name))
+    {
         options_map[name] = value;
+
+        if (changed)
+            changed();
+    }
     else
         sync_cout << "No such option: " << name << sync_endl;
 }
@@ -68,12 +76,13 @@ const Option& OptionsMap::operator[](const std::string& name) const {
 void OptionsMap::add(const std::string& name, const Option& option) {
     if (!options_map.count(name))
     {
-        static size_t insert_order = 0;
+        // Insertion order is per map, several engines may build their own
+        const size_t insert_order = options_map.size();
 
         options_map[name] = option;
 
         options_map[name].parent = this;
-        options_map[name].idx    = insert_order++;
+        options_map[name].idx    = insert_order;
     }
     else
     {
@@ -159,12 +168,12 @@ Option& Option::operator=(const std::string& v) {
 
     if (type == "combo")
     {
-        OptionsMap         comboMap;  // To have case insensitive compare
-        std::string        token;
-        std::istringstream ss(defaultValue);
+        std::set<std::string, CaseInsensitiveLess> comboValues;
+        std::string                                 token;
+        std::istringstream                          ss(defaultValue);
         while (ss >> token)
-            comboMap.add(token, Option());
-        if (!comboMap.count(v) || v == "var")
+            comboValues.insert(token);
+        if (!comboValues.count(v) || v == "var")
             return *this;
     }
 
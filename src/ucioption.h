@@ -71,7 +71,8 @@ class Option {
 
 class OptionsMap {
    public:
-    using InfoListener = std::function<void(std::optional<std::string>)>;
+    using InfoListener   = std::function<void(std::optional<std::string>)>;
+    using ChangeListener = std::function<void()>;
 
     OptionsMap()                             = default;
     OptionsMap(const OptionsMap&)            = delete;
@@ -80,6 +81,7 @@ class OptionsMap {
     OptionsMap& operator=(OptionsMap&&)      = delete;
 
     void add_info_listener(InfoListener&&);
+    void add_change_listener(ChangeListener&&);
 
     void setoption(std::istringstream&);
 
@@ -98,8 +100,9 @@ class OptionsMap {
     // The options container is defined as a std::map
     using OptionsStore = std::map<std::string, Option, CaseInsensitiveLess>;
 
-    OptionsStore options_map;
-    InfoListener info;
+    OptionsStore   options_map;
+    InfoListener   info;
+    ChangeListener changed;
 };
 
 }
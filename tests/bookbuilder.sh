@@ -0,0 +1,44 @@
+#!/bin/bash
+# verify that pgn_to_book reads every move of a small PGN, including castling
+# written with zeros and move numbers glued to the moves
+
+error()
+{
+  echo "bookbuilder testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "bookbuilder testing started"
+
+cat << EOF > castling.pgn
+[Event "Numeric castling, kingside"]
+[Result "1-0"]
+
+1. e4 e5 2. Nf3 Nc6 3. Bc4 Bc5 4. 0-0 4...Nf6 5.d3 0-0 1-0
+
+[Event "Numeric castling, queenside"]
+[Result "1/2-1/2"]
+
+1. d4 d5 2. Nc3 Nc6 3. Bf4 Bf5 4. Qd2 Qd7 5. 0-0-0 0-0-0+ {both sides} 1/2-1/2
+
+[Event "Letter castling"]
+[Result "0-1"]
+
+1. e4 e5 2. Nf3 Nc6 3. Bc4 Bc5 4. O-O Nf6 5. d3 O-O 0-1
+EOF
+
+cat << EOF > bookbuilder.exp
+   set timeout 10
+   spawn ./stockfish
+   send "pgn_to_book castling.pgn castling.bin\\n"
+   expect "3 games (0 skipped, 0 with illegal moves), 30 moves" {} timeout {exit 1}
+   send "quit\\n"
+   expect eof
+EOF
+
+expect bookbuilder.exp > /dev/null
+
+rm bookbuilder.exp castling.pgn castling.bin
+
+echo "bookbuilder testing OK"
@@ -0,0 +1,55 @@
+#!/bin/bash
+# verify that with Nodes Per Thread the reported node total equals the go nodes
+# limit, with one and with several threads
+
+error()
+{
+  echo "nodesperthread testing failed on line $1"
+  exit 1
+}
+trap 'error ${LINENO}' ERR
+
+echo "nodesperthread testing started"
+
+cat << EOF > nodes.exp
+ set timeout 30
+ spawn ./stockfish
+ lassign \$argv threads nodes
+
+ send "uci\n"
+ expect "uciok"
+
+ send "setoption name Threads value \$threads\n"
+ send "setoption name Nodes Per Thread value true\n"
+
+ send "ucinewgame\n"
+ send "position startpos\n"
+ send "go nodes \$nodes\n"
+ expect "bestmove"
+
+ send "position fen r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1\n"
+ send "go nodes \$nodes\n"
+ expect "bestmove"
+
+ send "quit\n"
+ expect eof
+EOF
+
+# the last info line before each bestmove reports the total. Quotas stay well
+# above the nodes of a depth 1 search, which every thread completes first.
+for threads in 1 4
+do
+  for nodes in 10000 123457
+  do
+    echo "nodesperthread testing with $threads threads and $nodes nodes"
+
+    expect nodes.exp $threads $nodes 2>&1 | awk -v nodes=$nodes '
+      /^info depth/ { for (i = 1; i < NF; i++) if ($i == "nodes") last = $(i + 1) }
+      /^bestmove/   { if (last != nodes) exit(1); searches++ }
+      END           { if (searches != 2) exit(1) }'
+  done
+done
+
+rm nodes.exp
+
+echo "nodesperthread testing OK"